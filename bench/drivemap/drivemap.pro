@@ -0,0 +1,25 @@
+QT       += core gui widgets
+
+QMAKE_CXXFLAGS += -std=c++11
+
+TARGET = drivemap
+
+CONFIG += console
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+INCLUDEPATH += ../../src
+
+SOURCES += main.cpp \
+    ../../src/filesystem.cpp \
+    ../../src/waitdialog.cpp \
+    ../../src/singletondialog.cpp \
+    ../../src/singletonwidget.cpp
+
+HEADERS  += ../../src/filesystem.h \
+    ../../src/waitdialog.h \
+    ../../src/singletondialog.h \
+    ../../src/singletonwidget.h
+
+FORMS    += ../../src/waitdialog.ui
@@ -0,0 +1,104 @@
+/***************************************************************************
+ *   Copyright (C) 2016 by Vitalii Kachemtsev <LLIAKAJL@yandex.ru>         *
+ *                                                                         *
+ *   This file is part of Wine Wizard.                                     *
+ *                                                                         *
+ *   Wine Wizard is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   Wine Wizard is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with Wine Wizard.  If not, see <http://www.gnu.org/licenses/>.  *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QCoreApplication>
+#include <QStandardPaths>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QFile>
+
+#include "filesystem.h"
+
+const int ITERATIONS = 100000;
+const QString PREFIX = "bench";
+
+static QString legacyWinPath(const QString &prefixHash, const QString &path)
+{
+    QString res(path);
+    for (char c = 'a'; c <= 'z'; ++c)
+    {
+        QString targetDrivePath = FS::driveTarget(prefixHash, QString(c) + ":").absolutePath();
+        QString drivePath = FS::drive(prefixHash, QString(c) + ":").absolutePath();
+        QString driveLetter = QString(QChar::toUpper(c)) + ":/";
+        if (res.startsWith(targetDrivePath))
+        {
+            res.replace(0, targetDrivePath.length(), driveLetter);
+            break;
+        }
+        else if (res.startsWith(drivePath))
+        {
+            res.replace(0, drivePath.length(), driveLetter);
+            break;
+        }
+    }
+    return res.replace("//", "/").replace('/', '\\');
+}
+
+static QString legacyUnixPath(const QString &prefixHash, const QString &path)
+{
+    QString res(path);
+    res.replace('\\', '/');
+    QString target = FS::driveTarget(prefixHash, QString(res.at(0).toLower()) + ":").absolutePath();
+    if (!target.endsWith('/'))
+        target += '/';
+    return res.replace(0, 3, target);
+}
+
+static qint64 measure(const std::function<void ()> &func)
+{
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < ITERATIONS; ++i)
+        func();
+    return timer.nsecsElapsed() / ITERATIONS;
+}
+
+int main(int argc, char *argv[])
+{
+    QStandardPaths::setTestModeEnabled(true);
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("winewizard-bench");
+    QDir prefix = FS::prefix(PREFIX);
+    prefix.removeRecursively();
+    QDir devices = FS::devices(PREFIX);
+    devices.mkpath(devices.absolutePath());
+    for (char c = 'a'; c <= 'z'; ++c)
+    {
+        QString target = prefix.absoluteFilePath(QString("drive_") + c);
+        QDir().mkpath(target);
+        QFile::link(target, devices.absoluteFilePath(QString(c) + ':'));
+    }
+    QString unixPath = prefix.absoluteFilePath("drive_z/Program Files/Game/game.exe");
+    QString winPath = "Z:\\Program Files\\Game\\game.exe";
+    QTextStream out(stdout);
+    if (FS::toWinPath(PREFIX, unixPath) != legacyWinPath(PREFIX, unixPath) ||
+        FS::toUnixPath(PREFIX, winPath) != legacyUnixPath(PREFIX, winPath))
+    {
+        out << "Conversion results differ" << endl;
+        prefix.removeRecursively();
+        return 1;
+    }
+    out << "toWinPath   legacy " << measure([&]{ legacyWinPath(PREFIX, unixPath); }) << " ns, cached "
+        << measure([&]{ FS::toWinPath(PREFIX, unixPath); }) << " ns" << endl;
+    out << "toUnixPath  legacy " << measure([&]{ legacyUnixPath(PREFIX, winPath); }) << " ns, cached "
+        << measure([&]{ FS::toUnixPath(PREFIX, winPath); }) << " ns" << endl;
+    prefix.removeRecursively();
+    return 0;
+}
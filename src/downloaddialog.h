@@ -21,10 +21,10 @@
 #ifndef DOWNLOADDIALOG_H
 #define DOWNLOADDIALOG_H
 
-#include <QNetworkAccessManager>
-
 #include "netdialog.h"
 
+class Transfer;
+
 namespace Ui {
 class DownloadDialog;
 }
@@ -43,17 +43,11 @@ public:
 
 private slots:
     void downloadProgress(qint64 bytesReceived, qint64 bytesTotal);
-    void downloadFinished();
-    void readyRead();
     void on_buttonBox_helpRequested();
 
 private:
     Ui::DownloadDialog *ui;
-    QString mOutFile, mCheckSum;
-    QStringList mMirrors, mReList;
-
-    void download();
-    void retry();
+    Transfer *mTransfer;
 };
 
 #endif // DOWNLOADDIALOG_H
@@ -21,6 +21,7 @@
 #include <QSortFilterProxyModel>
 #include <QStandardItemModel>
 #include <QDesktopServices>
+#include <QRegExpValidator>
 #include <QSettings>
 #include <QUrl>
 
@@ -28,6 +29,8 @@
 #include "editshortcutdialog.h"
 #include "editprefixdialog.h"
 #include "filesystem.h"
+#include "executor.h"
+#include "launcher.h"
 #include "netdialog.h"
 #include "dialogs.h"
 
@@ -55,6 +58,15 @@ EditPrefixDialog::EditPrefixDialog(const QString &prefixHash, QWidget *parent) :
                                         style()->standardIcon(QStyle::SP_DirIcon);;
     ui->icon->setIcon(icon);
     ui->name->setText(mPrefixName);
+    ui->affinity->setValidator(new QRegExpValidator(QRegExp("[0-9,-]*"), this));
+    solSett.beginGroup("Resources");
+    ui->nice->setValue(solSett.value("Nice", 0).toInt());
+    ui->ioClass->setCurrentIndex(solSett.value("IOClass", 0).toInt());
+    ui->affinity->setText(solSett.value("Affinity").toString());
+    ui->memoryMax->setValue(solSett.value("MemoryMax", 0).toInt());
+    ui->cpuQuota->setValue(solSett.value("CPUQuota", 0).toInt());
+    solSett.endGroup();
+    ui->presets->setPresets(Ex::presets(solSett));
     QStandardItemModel *model = new QStandardItemModel(this);
     QDir shDir = FS::shortcuts(mPrefixHash);
     QDir iDir = FS::icons(mPrefixHash);
@@ -75,6 +87,7 @@ EditPrefixDialog::EditPrefixDialog(const QString &prefixHash, QWidget *parent) :
         item->setData(args, ArgsRole);
         item->setData(debug, DebugRole);
         item->setData(shortcut, HashRole);
+        item->setData(Ex::presets(s, false), PresetRole);
         model->appendRow(item);
     }
     model->sort(0);
@@ -98,6 +111,7 @@ void EditPrefixDialog::accept()
     QStandardItemModel *model = static_cast<QStandardItemModel *>(ui->shortcuts->model());
     QDir iDir = FS::icons(mPrefixHash);
     QDir sDir = FS::shortcuts(mPrefixHash);
+    QDir pDir = sDir.absoluteFilePath(".prefetch");
     for (int i = model->rowCount() - 1; i >= 0; --i)
     {
         QStandardItem *item = model->item(i);
@@ -107,6 +121,7 @@ void EditPrefixDialog::accept()
         {
             iDir.rename(itemHash, hash);
             sDir.rename(itemHash, hash);
+            pDir.rename(itemHash, hash);
         }
         item->setData(hash, HashRole);
         QSettings s(sDir.absoluteFilePath(hash), QSettings::IniFormat);
@@ -115,6 +130,7 @@ void EditPrefixDialog::accept()
         s.setValue("WorkDir", FS::toWinPath(mPrefixHash, item->data(WorkDirRole).toString()));
         s.setValue("Args", item->data(ArgsRole));
         s.setValue("Debug", item->data(DebugRole));
+        Ex::setPresets(s, item->data(PresetRole).toMap());
         QString iconPath = item->data(IconRole).toString();
         if (!iconPath.isEmpty())
         {
@@ -127,9 +143,11 @@ void EditPrefixDialog::accept()
         if (model->match(model->index(0, 0), HashRole, hash, -1, Qt::MatchCaseSensitive).isEmpty())
         {
             sDir.remove(hash);
+            pDir.remove(hash);
             if (iDir.exists(hash))
                 iDir.remove(hash);
         }
+    Ex::invalidate(mPrefixHash);
     QDir solDir = FS::prefix(mPrefixHash);
     if (!mIcon.isEmpty())
     {
@@ -141,11 +159,28 @@ void EditPrefixDialog::accept()
     if (name != mPrefixName)
     {
         QString hash = FS::hash(name);
+        Launcher::removeAll(mPrefixHash);
         FS::data().rename(mPrefixHash, hash);
-        QSettings s(solDir.absoluteFilePath(".settings"), QSettings::IniFormat);
+        mPrefixHash = hash;
+        Ex::invalidate(hash);
+        QSettings s(FS::prefix(hash).absoluteFilePath(".settings"), QSettings::IniFormat);
         s.setIniCodec("UTF-8");
         s.setValue("Name", name);
     }
+    {
+        QSettings s(FS::prefix(mPrefixHash).absoluteFilePath(".settings"), QSettings::IniFormat);
+        s.setIniCodec("UTF-8");
+        Ex::setPresets(s, ui->presets->presets());
+        s.beginGroup("Resources");
+        s.setValue("Nice", ui->nice->value());
+        s.setValue("IOClass", ui->ioClass->currentIndex());
+        s.setValue("Affinity", ui->affinity->text().trimmed());
+        s.setValue("MemoryMax", ui->memoryMax->value());
+        s.setValue("CPUQuota", ui->cpuQuota->value());
+        s.endGroup();
+    }
+    Ex::invalidate(mPrefixHash);
+    Launcher::update(mPrefixHash);
     QDialog::accept();
 }
 
@@ -23,6 +23,7 @@
 
 #include "singletondialog.h"
 
+
 namespace Ui {
 class EditPrefixDialog;
 }
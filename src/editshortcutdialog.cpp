@@ -43,6 +43,8 @@ EditShortcutDialog::EditShortcutDialog(const QString &prefixHash, const QModelIn
     ui->workDir->setText(index.data(WorkDirRole).toString());
     ui->args->setText(index.data(ArgsRole).toString());
     ui->icon->setIcon(index.data(Qt::DecorationRole).value<QIcon>());
+    ui->presets->setInherit(true);
+    ui->presets->setPresets(index.data(PresetRole).toMap());
 }
 
 EditShortcutDialog::~EditShortcutDialog()
@@ -64,6 +66,7 @@ void EditShortcutDialog::accept()
     model->setData(mIndex, tArgs, ArgsRole);
     if (debug)
         model->setData(mIndex, true, DebugRole);
+    model->setData(mIndex, ui->presets->presets(), PresetRole);
     if (!mIcon.isEmpty())
     {
         model->setData(mIndex, QIcon(mIcon), Qt::DecorationRole);
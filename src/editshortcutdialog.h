@@ -25,11 +25,12 @@
 
 #include "singletondialog.h"
 
+
 namespace Ui {
 class EditShortcutDialog;
 }
 
-enum { ExeRole = Qt::UserRole + 1, WorkDirRole, ArgsRole, DebugRole, HashRole, IconRole };
+enum { ExeRole = Qt::UserRole + 1, WorkDirRole, ArgsRole, DebugRole, HashRole, IconRole, PresetRole };
 
 class EditShortcutDialog : public SingletonDialog
 {
@@ -0,0 +1,134 @@
+/***************************************************************************
+ *   Copyright (C) 2016 by Vitalii Kachemtsev <LLIAKAJL@yandex.ru>         *
+ *                                                                         *
+ *   This file is part of Wine Wizard.                                     *
+ *                                                                         *
+ *   Wine Wizard is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   Wine Wizard is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with Wine Wizard.  If not, see <http://www.gnu.org/licenses/>.  *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QStandardPaths>
+#include <QApplication>
+#include <QSettings>
+#include <QUuid>
+
+#include "filesystem.h"
+#include "templates.h"
+#include "ephemeral.h"
+#include "process.h"
+
+const QString EPHEMERAL_PREFIX = ".tmp-";
+
+static QDir runtime()
+{
+    QString path = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+    QDir res = path.isEmpty() ? FS::temp() : QDir(path).absoluteFilePath("winewizard");
+    if (!res.exists())
+        res.mkpath(res.absolutePath());
+    return res;
+}
+
+static void discard(const QString &prefixHash)
+{
+    QFileInfo link(FS::data().absoluteFilePath(prefixHash));
+    QString target = link.symLinkTarget();
+    QFile::remove(link.absoluteFilePath());
+    if (!target.isEmpty())
+        QDir(target).removeRecursively();
+    Ex::invalidate(prefixHash);
+}
+
+Ephemeral::Ephemeral(const QString &sourceHash, QObject *parent) :
+    QObject(parent),
+    mSourceHash(sourceHash),
+    mPrefixHash(EPHEMERAL_PREFIX + QUuid::createUuid().toString().mid(1, 8)),
+    mExitCode(-1)
+{
+}
+
+const QString &Ephemeral::prefixHash() const
+{
+    return mPrefixHash;
+}
+
+const Ex::Log &Ephemeral::log() const
+{
+    return mLog;
+}
+
+const Ex::Analyzer &Ephemeral::analyzer() const
+{
+    return mAnalyzer;
+}
+
+int Ephemeral::exitCode() const
+{
+    return mExitCode;
+}
+
+void Ephemeral::start(const QString &exe)
+{
+    mExe = exe;
+    QDir dir = runtime().absoluteFilePath(mPrefixHash.mid(1));
+    dir.mkpath(dir.absolutePath());
+    QString wine = FS::wine(mSourceHash).canonicalPath();
+    QFile::link(wine, dir.absoluteFilePath(".wine"));
+    QFile::link(FS::logs(mSourceHash).absolutePath(), dir.absoluteFilePath(".logs"));
+    QFile::copy(FS::prefix(mSourceHash).absoluteFilePath(".settings"), dir.absoluteFilePath(".settings"));
+    QFile::link(dir.absolutePath(), FS::data().absoluteFilePath(mPrefixHash));
+    Ex::invalidate(mPrefixHash);
+    QString build = QFileInfo(wine).fileName();
+    QString script = FS::readFile(":/create");
+    QProcessEnvironment overlay;
+    if (Templates::exists(build.section('-', 0, -2), build.section('-', -1)))
+    {
+        script = FS::readFile(":/clone");
+        overlay.insert("WW_TEMPLATE", Templates::path(build.section('-', 0, -2), build.section('-', -1)));
+    }
+    Ex::Job *job = Ex::start(Ex::Job::Release, script + FS::readFile(":/fixup"), mPrefixHash, overlay);
+    connect(job, &Ex::Job::finished, this, &Ephemeral::prefixCreated);
+}
+
+void Ephemeral::cleanup()
+{
+    for (const QString &hash : FS::data().entryList(QStringList(EPHEMERAL_PREFIX + '*'), QDir::AllEntries | QDir::Hidden | QDir::System))
+        if (Proc::prefixProcesses(FS::prefix(hash).absolutePath()).isEmpty())
+            discard(hash);
+}
+
+void Ephemeral::prefixCreated()
+{
+    if (qApp->property("Quit").toBool())
+    {
+        finish();
+        return;
+    }
+    Ex::Job *job = Ex::launch(Ex::Job::Debug, mExe, QString(), QString(), mPrefixHash);
+    connect(job, &Ex::Job::finished, this, &Ephemeral::applicationFinished);
+}
+
+void Ephemeral::applicationFinished(Ex::Job *job)
+{
+    mLog = job->log();
+    mAnalyzer = job->analyzer();
+    mExitCode = job->exitCode();
+    Ex::Job *termJob = Ex::start(Ex::Job::Release, FS::readFile(":/terminate"), mPrefixHash);
+    connect(termJob, &Ex::Job::finished, this, &Ephemeral::finish);
+}
+
+void Ephemeral::finish()
+{
+    discard(mPrefixHash);
+    emit finished(this);
+}
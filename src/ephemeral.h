@@ -0,0 +1,55 @@
+/***************************************************************************
+ *   Copyright (C) 2016 by Vitalii Kachemtsev <LLIAKAJL@yandex.ru>         *
+ *                                                                         *
+ *   This file is part of Wine Wizard.                                     *
+ *                                                                         *
+ *   Wine Wizard is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   Wine Wizard is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with Wine Wizard.  If not, see <http://www.gnu.org/licenses/>.  *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef EPHEMERAL_H
+#define EPHEMERAL_H
+
+#include "executor.h"
+
+class Ephemeral : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit Ephemeral(const QString &sourceHash, QObject *parent = nullptr);
+
+    const QString &prefixHash() const;
+    const Ex::Log &log() const;
+    const Ex::Analyzer &analyzer() const;
+    int exitCode() const;
+    void start(const QString &exe);
+
+    static void cleanup();
+
+signals:
+    void finished(Ephemeral *ephemeral);
+
+private:
+    QString mSourceHash, mPrefixHash, mExe;
+    Ex::Log mLog;
+    Ex::Analyzer mAnalyzer;
+    int mExitCode;
+
+    void prefixCreated();
+    void applicationFinished(Ex::Job *job);
+    void finish();
+};
+
+#endif // EPHEMERAL_H
@@ -18,78 +18,546 @@
  *                                                                         *
  ***************************************************************************/
 
-#include <QApplication>
-#include <QEventLoop>
-#include <QProcess>
+#include <QElapsedTimer>
+#include <QStandardPaths>
+#include <QSettings>
+
+#include <signal.h>
 
 #include "terminaldialog.h"
+#include "shadercache.h"
 #include "waitdialog.h"
 #include "filesystem.h"
 #include "executor.h"
+#include "process.h"
 #include "dialogs.h"
 
+const int IDLE_INTERVAL = 500;
+const int TERMINATE_TIMEOUT = 5000;
+const int KILL_TIMEOUT = 3000;
+const int KILL_POLL = 100;
+
 namespace Ex
 {
-    QProcessEnvironment env(const QString &prefixHash)
+    static int gLastId = 0;
+    static QList<Job *> gJobs;
+    static QHash<QString, QProcessEnvironment> gEnvCache;
+    static QHash<QString, QStringList> gSlices;
+
+    Job::Job(int id, Mode mode, const QString &prefixHash) :
+        mId(id),
+        mExitCode(-1),
+        mMode(mode),
+        mState(Running),
+        mPrefixHash(prefixHash),
+        mStarted(QDateTime::currentDateTime()),
+        mProcDone(false),
+        mWatch(false)
+    {
+        gJobs.append(this);
+        mIdleTimer.setInterval(IDLE_INTERVAL);
+        connect(&mIdleTimer, &QTimer::timeout, this, &Job::checkIdle);
+    }
+
+    Job::~Job()
+    {
+        gJobs.removeOne(this);
+        if (mProc.state() != QProcess::NotRunning)
+        {
+            mProc.kill();
+            mProc.waitForFinished();
+        }
+        delete mDialog;
+    }
+
+    int Job::id() const
+    {
+        return mId;
+    }
+
+    Job::Mode Job::mode() const
+    {
+        return mMode;
+    }
+
+    Job::State Job::state() const
+    {
+        return mState;
+    }
+
+    const QString &Job::prefixHash() const
+    {
+        return mPrefixHash;
+    }
+
+    int Job::exitCode() const
+    {
+        return mExitCode;
+    }
+
+    const QDateTime &Job::started() const
+    {
+        return mStarted;
+    }
+
+    Log Job::log() const
+    {
+        return mLog;
+    }
+
+    Analyzer Job::analyzer() const
+    {
+        return mAnalyzer;
+    }
+
+    void Job::run(const QString &program, const QStringList &args, const QProcessEnvironment &overlay, QWidget *parent)
+    {
+        QProcessEnvironment e = env(mPrefixHash, overlay, mExe);
+        if (!mExe.isEmpty())
+        {
+            QDateTime since = mStarted;
+            for (Job *job : gJobs)
+                if (job->state() == Running && job->started() < since)
+                    since = job->started();
+            Shaders::touch(mExe, since);
+        }
+        if (mMode == Release && e.value("WW_QUIET", "1") == "1" && !overlay.contains("WINEDEBUG") &&
+            e.value("WINEDEBUG") == QProcessEnvironment::systemEnvironment().value("WINEDEBUG"))
+            e.insert("WINEDEBUG", "-all");
+        mProc.setProcessEnvironment(e);
+        connect(&mProc, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished),
+                this, &Job::processFinished);
+        connect(&mProc, static_cast<void (QProcess::*)(QProcess::ProcessError)>(&QProcess::error), this, [this](QProcess::ProcessError err)
+        {
+            if (err == QProcess::FailedToStart)
+                processFinished();
+        });
+        if (mMode == Debug || mMode == Terminal)
+        {
+            QDir logs = mPrefixHash.isEmpty() ? FS::temp() : FS::logs(mPrefixHash);
+            if (mMode == Terminal)
+            {
+                logs.mkpath("terminal");
+                logs.cd("terminal");
+            }
+            mLog = Log(new RunLog(logs));
+            connect(&mProc, &QProcess::readyReadStandardOutput, this, [this]{ mLog->append(RunLog::Out, mProc.readAllStandardOutput()); });
+            connect(&mProc, &QProcess::readyReadStandardError, this, [this]{ mLog->append(RunLog::Err, mProc.readAllStandardError()); });
+        }
+        else
+        {
+            mProc.setStandardOutputFile(QProcess::nullDevice());
+            mProc.setStandardErrorFile(QProcess::nullDevice());
+        }
+        if (mMode == Debug)
+            mAnalyzer = Analyzer(new LogAnalyzer(mLog.data()));
+        else if (mMode == Terminal)
+        {
+            TerminalDialog *td = new TerminalDialog(mLog, parent);
+            mDialog = td;
+            connect(td, &QDialog::finished, this, [this]{ if (mProcDone) finish(); });
+            connect(td, &TerminalDialog::stopRequested, this, [this]
+            {
+                if (!mPrefixHash.isEmpty())
+                    Proc::send(FS::prefix(mPrefixHash).absolutePath(), SIGKILL);
+                mProc.kill();
+            });
+            td->show();
+        }
+        mProc.start(program, args);
+    }
+
+    void Job::processFinished()
+    {
+        if (mProcDone)
+            return;
+        mProcDone = true;
+        mExitCode = mProc.exitStatus() == QProcess::NormalExit ? mProc.exitCode() : -1;
+        if (mLog)
+        {
+            mLog->append(RunLog::Out, mProc.readAllStandardOutput());
+            mLog->append(RunLog::Err, mProc.readAllStandardError());
+            mLog->flush();
+        }
+        if (mAnalyzer)
+            mAnalyzer->finish();
+        if (mMode == Terminal && mDialog)
+        {
+            TerminalDialog *td = static_cast<TerminalDialog *>(mDialog.data());
+            td->executeFinished();
+            if (td->isVisible())
+                return;
+        }
+        else if (mDialog)
+            mDialog->accept();
+        if (mWatch && !Proc::idle(FS::prefix(mPrefixHash).absolutePath()))
+            mIdleTimer.start();
+        else
+            finish();
+    }
+
+    void Job::checkIdle()
+    {
+        if (Proc::idle(FS::prefix(mPrefixHash).absolutePath()))
+        {
+            mIdleTimer.stop();
+            finish();
+        }
+    }
+
+    void Job::finish()
+    {
+        if (mState == Finished)
+            return;
+        mState = Finished;
+        gJobs.removeOne(this);
+        emit finished(this);
+        deleteLater();
+    }
+
+    QProcessEnvironment env(const QString &prefixHash, const QProcessEnvironment &overlay, const QString &exe)
     {
-        QProcessEnvironment res = QProcessEnvironment::systemEnvironment();
-        if (!prefixHash.isEmpty())
+        QHash<QString, QProcessEnvironment>::iterator cached = gEnvCache.find(prefixHash);
+        if (cached == gEnvCache.end())
         {
-            res.insert("WINEPREFIX", FS::prefix(prefixHash).absolutePath());
-            QString winePath = FS::wine(prefixHash).absolutePath();
-            res.insert("WINEVERPATH", winePath);
-            res.insert("PATH", winePath + "/bin:" + res.value("PATH"));
-            res.insert("WINESERVER", winePath + "/bin/wineserver");
-            res.insert("WINELOADER", winePath + "/bin/wine");
-            res.insert("WINEDLLPATH", winePath + "/lib/wine/fakedlls");
-            res.insert("LD_LIBRARY_PATH", winePath + "/lib:" + res.value("LD_LIBRARY_PATH"));
-            res.insert("WINEDLLOVERRIDES", "winemenubuilder.exe=n");
+            QProcessEnvironment res = QProcessEnvironment::systemEnvironment();
+            if (!prefixHash.isEmpty())
+            {
+                QDir prefix = FS::prefix(prefixHash);
+                res.insert("WINEPREFIX", prefix.absolutePath());
+                QString winePath = FS::wine(prefixHash).absolutePath();
+                res.insert("WINEVERPATH", winePath);
+                res.insert("PATH", winePath + "/bin:" + res.value("PATH"));
+                res.insert("WINESERVER", winePath + "/bin/wineserver");
+                res.insert("WINELOADER", winePath + "/bin/wine");
+                res.insert("WINEDLLPATH", winePath + "/lib/wine/fakedlls");
+                res.insert("LD_LIBRARY_PATH", winePath + "/lib:" + res.value("LD_LIBRARY_PATH"));
+                res.insert("WINEDLLOVERRIDES", "winemenubuilder.exe=n");
+                QSettings s(prefix.absoluteFilePath(".settings"), QSettings::IniFormat);
+                s.setIniCodec("UTF-8");
+                res.insert(Ex::overlay(presets(s)));
+            }
+            cached = gEnvCache.insert(prefixHash, res);
         }
+        if (overlay.isEmpty() && exe.isEmpty())
+            return cached.value();
+        QProcessEnvironment res = cached.value();
+        if (!exe.isEmpty())
+        {
+            QProcessEnvironment shaders = Shaders::env(exe);
+            for (const QString &key : shaders.keys())
+                if (!res.contains(key))
+                    res.insert(key, shaders.value(key));
+        }
+        res.insert(overlay);
         return res;
     }
 
-    void release(const QString &script, const QString &prefixHash)
+    QVariantMap presets(QSettings &s, bool server)
     {
-        QProcess proc;
-        QProcessEnvironment e = env(prefixHash);
-        e.insert("WINEDEBUG", "-all");
-        proc.setProcessEnvironment(e);
-        QEventLoop loop;
-        proc.connect(&proc, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished), &loop, &QEventLoop::quit);
-        proc.start("sh", QStringList("-c") << script);
-        loop.exec();
+        QVariantMap res;
+        s.beginGroup("Performance");
+        for (const QString &key : PRESETS)
+            if (s.contains(key) && (server || !SERVER_PRESETS.contains(key)))
+                res.insert(key, s.value(key).toBool());
+        s.endGroup();
+        res.insert("Environment", s.value("Environment").toStringList());
+        return res;
     }
 
-    Out debug(const QString &script, const QString &prefixHash)
+    void setPresets(QSettings &s, const QVariantMap &presets)
     {
-        QProcess proc;
-        proc.setProcessEnvironment(env(prefixHash));
-        QEventLoop loop;
-        proc.connect(&proc, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished), &loop, &QEventLoop::quit);
-        proc.start("sh", QStringList("-c") << script);
-        loop.exec();
-        return qMakePair(proc.readAllStandardOutput(), proc.readAllStandardError());
+        s.beginGroup("Performance");
+        for (const QString &key : PRESETS)
+            if (presets.contains(key))
+                s.setValue(key, presets.value(key).toBool());
+            else
+                s.remove(key);
+        s.endGroup();
+        QStringList vars = presets.value("Environment").toStringList();
+        if (vars.isEmpty())
+            s.remove("Environment");
+        else
+            s.setValue("Environment", vars);
+    }
+
+    QProcessEnvironment overlay(const QVariantMap &presets)
+    {
+        QProcessEnvironment res;
+        if (presets.contains("Esync"))
+            res.insert("WINEESYNC", presets.value("Esync").toBool() ? "1" : "0");
+        if (presets.contains("Fsync"))
+            res.insert("WINEFSYNC", presets.value("Fsync").toBool() ? "1" : "0");
+        if (presets.contains("SharedMemory"))
+            res.insert("STAGING_SHARED_MEMORY", presets.value("SharedMemory").toBool() ? "1" : "0");
+        if (presets.contains("ThreadedGL"))
+        {
+            bool on = presets.value("ThreadedGL").toBool();
+            res.insert("__GL_THREADED_OPTIMIZATIONS", on ? "1" : "0");
+            res.insert("mesa_glthread", on ? "true" : "false");
+        }
+        if (presets.contains("Quiet"))
+            res.insert("WW_QUIET", presets.value("Quiet").toBool() ? "1" : "0");
+        for (const QString &var : presets.value("Environment").toStringList())
+        {
+            int eq = var.indexOf('=');
+            if (eq > 0)
+                res.insert(var.left(eq).trimmed(), var.mid(eq + 1));
+        }
+        return res;
     }
 
-    void wait(const QString &script, const QString &prefixHash, QWidget *parent)
+    void invalidate(const QString &prefixHash)
     {
-        QProcess proc;
-        proc.setProcessEnvironment(env(prefixHash));
-        WaitDialog wd(parent);
-        proc.connect(&proc, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished), &wd, &WaitDialog::accept);
-        proc.start("sh", QStringList("-c") << script);
-        wd.exec();
+        if (prefixHash.isEmpty())
+            gEnvCache.clear();
+        else
+            gEnvCache.remove(prefixHash);
     }
 
-    void terminal(const QString &script, const QString &prefixHash, QWidget *parent)
+    QStringList wrapper(const QString &prefixHash)
     {
-        QProcess proc;
-        proc.setProcessEnvironment(env(prefixHash));
-        TerminalDialog td(parent);
-        proc.connect(&proc, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished), &td, &TerminalDialog::executeFinished);
-        proc.connect(&proc, &QProcess::readyReadStandardOutput, &td, [&td, &proc](){ td.appendOut(proc.readAllStandardOutput()); });
-        proc.connect(&proc, &QProcess::readyReadStandardError, &td, [&td, &proc](){ td.appendErr(proc.readAllStandardError()); });
-        proc.start("sh", QStringList("-c") << script);
-        td.exec();
+        QStringList res;
+        if (prefixHash.isEmpty())
+            return res;
+        QSettings s(FS::prefix(prefixHash).absoluteFilePath(".settings"), QSettings::IniFormat);
+        s.beginGroup("Resources");
+        int memory = s.value("MemoryMax", 0).toInt();
+        int cpu = s.value("CPUQuota", 0).toInt();
+        int nice = s.value("Nice", 0).toInt();
+        int io = s.value("IOClass", 0).toInt();
+        QString affinity = s.value("Affinity").toString().trimmed();
+        QString tool;
+        if ((memory > 0 || cpu > 0) && !(tool = QStandardPaths::findExecutable("systemd-run")).isEmpty())
+        {
+            QString slice = "winewizard-" + prefixHash + ".slice";
+            QStringList props;
+            props << "MemoryMax=" + (memory > 0 ? QString::number(memory) + 'M' : QString("infinity"));
+            props << "CPUQuota=" + (cpu > 0 ? QString::number(cpu) + '%' : QString());
+            QString ctl = QStandardPaths::findExecutable("systemctl");
+            if (gSlices.value(prefixHash) != props && !ctl.isEmpty() &&
+                QProcess::execute(ctl, QStringList() << "--user" << "set-property" << slice << props) == 0)
+                gSlices.insert(prefixHash, props);
+            res << tool << "--user" << "--scope" << "--quiet" << "--slice=" + slice;
+            if (gSlices.value(prefixHash) != props)
+                for (const QString &prop : props)
+                    res << "-p" << prop;
+            res << "--";
+        }
+        if (nice > 0 && !(tool = QStandardPaths::findExecutable("nice")).isEmpty())
+            res << tool << "-n" << QString::number(nice);
+        if (io > 0 && !(tool = QStandardPaths::findExecutable("ionice")).isEmpty())
+            res << tool << "-c" << (io == 1 ? QStringList() << "2" << "-n" << "7" : QStringList("3"));
+        if (!affinity.isEmpty() && !(tool = QStandardPaths::findExecutable("taskset")).isEmpty())
+            res << tool << "-c" << affinity;
+        return res;
+    }
+
+    Job *start(Job::Mode mode, const QString &script, const QString &prefixHash,
+               const QProcessEnvironment &overlay, QWidget *parent)
+    {
+        Job *job = new Job(++gLastId, mode, prefixHash);
+        QStringList cmd = wrapper(prefixHash);
+        cmd << "sh" << "-c" << script;
+        job->run(cmd.first(), cmd.mid(1), overlay, parent);
+        return job;
+    }
+
+    Job *launch(Job::Mode mode, const QString &exe, const QString &workDir, const QString &args,
+                const QString &prefixHash, const QProcessEnvironment &overlay)
+    {
+        QString wine = env(prefixHash).value("WINELOADER");
+        QString suffix = QFileInfo(exe).suffix().toLower();
+        bool direct = QSettings("winewizard", "settings").value("DirectLaunch", true).toBool();
+        Job *job = new Job(++gLastId, mode, prefixHash);
+        job->mExe = exe;
+        QStringList cmd = wrapper(prefixHash);
+        if (!direct || !QFileInfo(wine).isExecutable() || (suffix != "exe" && suffix != "msi"))
+            cmd << "sh" << "-c" << FS::readFile(":/run").arg(exe).arg(workDir).arg(args);
+        else
+        {
+            cmd << wine;
+            if (suffix == "msi")
+                cmd << "msiexec" << "/i" << FS::toWinPath(prefixHash, exe);
+            else
+                cmd << exe;
+            cmd << splitArgs(args);
+            job->mWatch = true;
+            job->mProc.setWorkingDirectory(workDir.isEmpty() ? QFileInfo(exe).absolutePath() : workDir);
+        }
+        job->run(cmd.first(), cmd.mid(1), overlay, nullptr);
+        return job;
+    }
+
+    QStringList splitArgs(const QString &args)
+    {
+        QStringList res;
+        QString arg;
+        bool inArg = false;
+        QChar quote;
+        for (int i = 0; i < args.length(); ++i)
+        {
+            QChar c = args.at(i);
+            if (!quote.isNull())
+            {
+                if (c == quote)
+                    quote = QChar();
+                else
+                    arg += c;
+            }
+            else if (c == '\\' && i + 1 < args.length())
+            {
+                arg += args.at(++i);
+                inArg = true;
+            }
+            else if (c == '"' || c == '\'')
+            {
+                quote = c;
+                inArg = true;
+            }
+            else if (c.isSpace())
+            {
+                if (inArg)
+                    res.append(arg);
+                arg.clear();
+                inArg = false;
+            }
+            else
+            {
+                arg += c;
+                inArg = true;
+            }
+        }
+        if (inArg)
+            res.append(arg);
+        return res;
+    }
+
+    QList<Job *> jobs(const QString &prefixHash)
+    {
+        if (prefixHash.isEmpty())
+            return gJobs;
+        QList<Job *> res;
+        for (Job *job : gJobs)
+            if (job->prefixHash() == prefixHash)
+                res.append(job);
+        return res;
+    }
+
+    QStringList running()
+    {
+        QStringList res;
+        for (Job *job : gJobs)
+            if (!job->prefixHash().isEmpty() && !res.contains(job->prefixHash()))
+                res.append(job->prefixHash());
+        return res;
+    }
+
+    class Terminator : public QObject
+    {
+    public:
+        Terminator(const QStringList &prefixHashes, const std::function<void ()> &done, QWidget *parent) :
+            mPrefixHashes(prefixHashes),
+            mLeft(prefixHashes),
+            mDone(done),
+            mDialog(new WaitDialog(parent)),
+            mEscalated(false)
+        {
+            mDialog->setProgress(0, mPrefixHashes.count());
+            mDialog->show();
+            QString script = FS::readFile(":/terminate");
+            for (const QString &prefixHash : mPrefixHashes)
+            {
+                Proc::resume(FS::prefix(prefixHash).absolutePath());
+                Job *job = start(Job::Release, script, prefixHash);
+                connect(job, &Job::finished, this, [this](Job *done)
+                {
+                    mLeft.removeOne(done->prefixHash());
+                    if (!mEscalated)
+                        mDialog->setProgress(mPrefixHashes.count() - mLeft.count(), mPrefixHashes.count());
+                    if (mLeft.isEmpty())
+                        escalate();
+                });
+            }
+            mTimer.setInterval(KILL_POLL);
+            connect(&mTimer, &QTimer::timeout, this, &Terminator::poll);
+            QTimer::singleShot(TERMINATE_TIMEOUT, this, &Terminator::escalate);
+        }
+
+        ~Terminator() override
+        {
+            delete mDialog;
+        }
+
+    private:
+        QStringList mPrefixHashes, mLeft, mAlive;
+        std::function<void ()> mDone;
+        QPointer<WaitDialog> mDialog;
+        QTimer mTimer;
+        QElapsedTimer mClock;
+        bool mEscalated;
+
+        void escalate()
+        {
+            if (mEscalated)
+                return;
+            mEscalated = true;
+            for (const QString &prefixHash : mPrefixHashes)
+            {
+                QString path = FS::prefix(prefixHash).absolutePath();
+                if (!Proc::prefixProcesses(path).isEmpty())
+                {
+                    Proc::send(path, SIGTERM);
+                    mAlive.append(path);
+                }
+            }
+            mClock.start();
+            mTimer.start();
+            poll();
+        }
+
+        void poll()
+        {
+            for (int i = mAlive.count() - 1; i >= 0; --i)
+                if (Proc::prefixProcesses(mAlive.at(i)).isEmpty())
+                    mAlive.removeAt(i);
+            if (!mAlive.isEmpty() && mClock.elapsed() < KILL_TIMEOUT)
+                return;
+            mTimer.stop();
+            for (const QString &path : mAlive)
+                Proc::send(path, SIGKILL);
+            mDialog->setProgress(mPrefixHashes.count(), mPrefixHashes.count());
+            if (mDone)
+                mDone();
+            deleteLater();
+        }
+    };
+
+    void terminate(const QStringList &prefixHashes, const std::function<void ()> &done, QWidget *parent)
+    {
+        if (prefixHashes.isEmpty())
+        {
+            if (done)
+                done();
+            return;
+        }
+        new Terminator(prefixHashes, done, parent);
+    }
+
+    void warm(const QString &prefixHash, int minutes)
+    {
+        QProcess *proc = new QProcess;
+        QProcessEnvironment e = env(prefixHash);
+        proc->setProcessEnvironment(e);
+        QObject::connect(proc, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished),
+                         proc, &QProcess::deleteLater);
+        QObject::connect(proc, static_cast<void (QProcess::*)(QProcess::ProcessError)>(&QProcess::error), proc, [proc](QProcess::ProcessError err)
+        {
+            if (err == QProcess::FailedToStart)
+                proc->deleteLater();
+        });
+        QStringList cmd = wrapper(prefixHash);
+        cmd << e.value("WINESERVER") << "-p" + QString::number(minutes * 60);
+        proc->start(cmd.first(), cmd.mid(1));
     }
 }
@@ -21,15 +21,91 @@
 #ifndef EXECUTOR_H
 #define EXECUTOR_H
 
-#include <QWidget>
+#include <functional>
+
+#include <QSharedPointer>
+#include <QDateTime>
+#include <QSettings>
+#include <QPointer>
+#include <QProcess>
+#include <QDialog>
+#include <QTimer>
+
+#include "loganalyzer.h"
+#include "runlog.h"
 
 namespace Ex
 {
-    typedef QPair<QString, QString> Out;
-    void release(const QString &script, const QString &prefixHash = QString());
-    Out debug(const QString &script, const QString &prefixHash = QString());
-    void wait(const QString &script, const QString &prefixHash = QString(), QWidget *parent = nullptr);
-    void terminal(const QString &script, const QString &prefixHash = QString(), QWidget *parent = nullptr);
+    typedef QSharedPointer<RunLog> Log;
+    typedef QSharedPointer<LogAnalyzer> Analyzer;
+
+    const QStringList PRESETS = QStringList() << "Esync" << "Fsync" << "SharedMemory" << "ThreadedGL" << "Quiet";
+    const QStringList SERVER_PRESETS = QStringList() << "Esync" << "Fsync" << "SharedMemory";
+
+    class Job : public QObject
+    {
+        Q_OBJECT
+
+    public:
+        enum Mode { Release, Debug, Terminal };
+        enum State { Running, Finished };
+
+        friend Job *start(Mode mode, const QString &script, const QString &prefixHash,
+                          const QProcessEnvironment &overlay, QWidget *parent);
+        friend Job *launch(Mode mode, const QString &exe, const QString &workDir, const QString &args,
+                           const QString &prefixHash, const QProcessEnvironment &overlay);
+
+        ~Job() override;
+
+        int id() const;
+        Mode mode() const;
+        State state() const;
+        const QString &prefixHash() const;
+        int exitCode() const;
+        const QDateTime &started() const;
+        Log log() const;
+        Analyzer analyzer() const;
+
+    signals:
+        void finished(Ex::Job *job);
+
+    private:
+        int mId, mExitCode;
+        Mode mMode;
+        State mState;
+        QString mPrefixHash, mExe;
+        QDateTime mStarted;
+        QProcess mProc;
+        QPointer<QDialog> mDialog;
+        bool mProcDone, mWatch;
+        QTimer mIdleTimer;
+        Log mLog;
+        Analyzer mAnalyzer;
+
+        explicit Job(int id, Mode mode, const QString &prefixHash);
+        void run(const QString &program, const QStringList &args, const QProcessEnvironment &overlay, QWidget *parent);
+        void processFinished();
+        void checkIdle();
+        void finish();
+    };
+
+    QProcessEnvironment env(const QString &prefixHash, const QProcessEnvironment &overlay = QProcessEnvironment(),
+                            const QString &exe = QString());
+    QVariantMap presets(QSettings &s, bool server = true);
+    void setPresets(QSettings &s, const QVariantMap &presets);
+    QProcessEnvironment overlay(const QVariantMap &presets);
+    void invalidate(const QString &prefixHash = QString());
+    QStringList wrapper(const QString &prefixHash);
+    Job *start(Job::Mode mode, const QString &script, const QString &prefixHash = QString(),
+               const QProcessEnvironment &overlay = QProcessEnvironment(), QWidget *parent = nullptr);
+    Job *launch(Job::Mode mode, const QString &exe, const QString &workDir, const QString &args,
+                const QString &prefixHash, const QProcessEnvironment &overlay = QProcessEnvironment());
+    QStringList splitArgs(const QString &args);
+    QList<Job *> jobs(const QString &prefixHash = QString());
+    QStringList running();
+    void terminate(const QStringList &prefixHashes, const std::function<void ()> &done = nullptr,
+                   QWidget *parent = nullptr);
+    void warm(const QString &prefixHash, int minutes);
 }
 
 #endif // EXECUTOR_H
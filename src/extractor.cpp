@@ -0,0 +1,242 @@
+/***************************************************************************
+ *   Copyright (C) 2016 by Vitalii Kachemtsev <LLIAKAJL@yandex.ru>         *
+ *                                                                         *
+ *   This file is part of Wine Wizard.                                     *
+ *                                                                         *
+ *   Wine Wizard is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   Wine Wizard is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with Wine Wizard.  If not, see <http://www.gnu.org/licenses/>.  *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QThreadPool>
+#include <QRunnable>
+#include <QAtomicInt>
+#include <QThread>
+#include <QSet>
+#include <QFile>
+#include <QDir>
+
+#include <archive_entry.h>
+#include <archive.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "extractor.h"
+
+const int BLOCK_SIZE = 64 * 1024;
+const qint64 MAX_BUFFERED = 256 * 1024 * 1024;
+const qint64 MAX_MEMBER = 64 * 1024 * 1024;
+const int DISK_FLAGS = ARCHIVE_EXTRACT_PERM | ARCHIVE_EXTRACT_TIME | ARCHIVE_EXTRACT_UNLINK |
+                       ARCHIVE_EXTRACT_SECURE_NODOTDOT | ARCHIVE_EXTRACT_SECURE_SYMLINKS;
+
+namespace Extractor
+{
+    static int openParent(int baseFd, const QByteArray &path, QByteArray &leaf)
+    {
+        QList<QByteArray> parts = path.split('/');
+        leaf = parts.takeLast();
+        int fd = ::dup(baseFd);
+        for (const QByteArray &part : parts)
+        {
+            if (fd < 0 || part.isEmpty() || part == ".")
+                continue;
+            if (part == "..")
+            {
+                ::close(fd);
+                return -1;
+            }
+            ::mkdirat(fd, part.constData(), 0755);
+            int next = ::openat(fd, part.constData(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+            ::close(fd);
+            fd = next;
+        }
+        return fd;
+    }
+
+    class WriteTask : public QRunnable
+    {
+    public:
+        WriteTask(int baseFd, const QByteArray &path, const QByteArray &data, mode_t mode, time_t mtime,
+                  QAtomicInt &failed, QAtomicInteger<qint64> &buffered) :
+            mBaseFd(baseFd),
+            mPath(path),
+            mData(data),
+            mMode(mode),
+            mTime(mtime),
+            mFailed(failed),
+            mBuffered(buffered)
+        {
+        }
+
+        void run() override
+        {
+            QByteArray leaf;
+            int dirFd = openParent(mBaseFd, mPath, leaf);
+            int fd = -1;
+            if (dirFd >= 0)
+            {
+                ::unlinkat(dirFd, leaf.constData(), 0);
+                fd = ::openat(dirFd, leaf.constData(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_NOFOLLOW, 0600);
+                ::close(dirFd);
+            }
+            bool ok = fd >= 0;
+            for (qint64 pos = 0; ok && pos < mData.size();)
+            {
+                ssize_t n = ::write(fd, mData.constData() + pos, mData.size() - pos);
+                ok = n > 0;
+                pos += n;
+            }
+            if (fd >= 0)
+            {
+                ok = ::fchmod(fd, mMode & 07777) == 0 && ok;
+                struct timespec times[2] = { { mTime, 0 }, { mTime, 0 } };
+                ::futimens(fd, times);
+                ok = ::close(fd) == 0 && ok;
+            }
+            if (!ok)
+            {
+                qWarning("%s: write failed", mPath.constData());
+                mFailed.store(1);
+            }
+            mBuffered.fetchAndAddOrdered(-mData.size());
+        }
+
+    private:
+        int mBaseFd;
+        QByteArray mPath, mData;
+        mode_t mMode;
+        time_t mTime;
+        QAtomicInt &mFailed;
+        QAtomicInteger<qint64> &mBuffered;
+    };
+
+    static bool readData(struct archive *a, QByteArray &res)
+    {
+        char buf[BLOCK_SIZE];
+        la_ssize_t n;
+        while ((n = archive_read_data(a, buf, sizeof(buf))) > 0)
+            res.append(buf, n);
+        return n == 0;
+    }
+
+    static bool copyData(struct archive *a, struct archive *disk)
+    {
+        const void *buf;
+        size_t size;
+        la_int64_t offset;
+        int r;
+        while ((r = archive_read_data_block(a, &buf, &size, &offset)) == ARCHIVE_OK)
+            if (archive_write_data_block(disk, buf, size, offset) != ARCHIVE_OK)
+                return false;
+        return r == ARCHIVE_EOF;
+    }
+
+    int run(const QString &archive, const QString &dir)
+    {
+        QDir root(dir);
+        if (!root.mkpath(root.absolutePath()))
+        {
+            qWarning("%s: cannot create directory", qPrintable(dir));
+            return 1;
+        }
+        QByteArray base = QFile::encodeName(root.canonicalPath());
+        struct archive *a = archive_read_new();
+        archive_read_support_filter_all(a);
+        archive_read_support_format_all(a);
+        if (archive_read_open_filename(a, QFile::encodeName(archive).constData(), BLOCK_SIZE) != ARCHIVE_OK)
+        {
+            qWarning("%s: %s", qPrintable(archive), archive_error_string(a));
+            archive_read_free(a);
+            return 1;
+        }
+        int baseFd = ::open(base.constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (baseFd < 0)
+        {
+            qWarning("%s: cannot open directory", base.constData());
+            archive_read_free(a);
+            return 1;
+        }
+        struct archive *disk = archive_write_disk_new();
+        archive_write_disk_set_options(disk, DISK_FLAGS);
+        archive_write_disk_set_standard_lookup(disk);
+        QThreadPool pool;
+        pool.setMaxThreadCount(QThread::idealThreadCount());
+        QAtomicInt failed;
+        QAtomicInteger<qint64> buffered;
+        QSet<QByteArray> pending;
+        struct archive_entry *entry;
+        int r;
+        while ((r = archive_read_next_header(a, &entry)) == ARCHIVE_OK || r == ARCHIVE_WARN)
+        {
+            QByteArray name = archive_entry_pathname(entry);
+            QByteArray path = QFile::encodeName(QDir::cleanPath(QFile::decodeName(base + '/' + name)));
+            if (name.isEmpty() || !(path + '/').startsWith(base + '/'))
+            {
+                qWarning("%s: unsafe path skipped", name.constData());
+                archive_read_data_skip(a);
+                continue;
+            }
+            archive_entry_set_pathname(entry, path.constData());
+            if (pending.contains(path))
+            {
+                pool.waitForDone();
+                pending.clear();
+            }
+            if (archive_entry_hardlink(entry))
+            {
+                pool.waitForDone();
+                pending.clear();
+                QByteArray link = base + '/' + archive_entry_hardlink(entry);
+                archive_entry_set_hardlink(entry, link.constData());
+            }
+            if (archive_entry_filetype(entry) == AE_IFREG && !archive_entry_hardlink(entry) &&
+                archive_entry_size(entry) > 0 && archive_entry_size(entry) <= MAX_MEMBER)
+            {
+                QByteArray data;
+                if (!readData(a, data))
+                {
+                    qWarning("%s: %s", name.constData(), archive_error_string(a));
+                    failed.store(1);
+                    break;
+                }
+                if (buffered.fetchAndAddOrdered(data.size()) > MAX_BUFFERED)
+                {
+                    pool.waitForDone();
+                    pending.clear();
+                }
+                pending.insert(path);
+                pool.start(new WriteTask(baseFd, path.mid(base.length() + 1), data, archive_entry_perm(entry),
+                                         archive_entry_mtime(entry), failed, buffered));
+                continue;
+            }
+            if (archive_write_header(disk, entry) != ARCHIVE_OK || !copyData(a, disk) ||
+                archive_write_finish_entry(disk) != ARCHIVE_OK)
+            {
+                qWarning("%s: %s", name.constData(), archive_error_string(disk));
+                failed.store(1);
+            }
+        }
+        if (r != ARCHIVE_EOF && r != ARCHIVE_OK && r != ARCHIVE_WARN)
+        {
+            qWarning("%s: %s", qPrintable(archive), archive_error_string(a));
+            failed.store(1);
+        }
+        pool.waitForDone();
+        ::close(baseFd);
+        archive_write_close(disk);
+        archive_write_free(disk);
+        archive_read_free(a);
+        return failed.load();
+    }
+}
@@ -0,0 +1,90 @@
+/***************************************************************************
+ *   Copyright (C) 2016 by Vitalii Kachemtsev <LLIAKAJL@yandex.ru>         *
+ *                                                                         *
+ *   This file is part of Wine Wizard.                                     *
+ *                                                                         *
+ *   Wine Wizard is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   Wine Wizard is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with Wine Wizard.  If not, see <http://www.gnu.org/licenses/>.  *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QSettings>
+#include <QTimer>
+
+#include "filesystem.h"
+#include "transfer.h"
+#include "fetcher.h"
+
+const int FETCH_RETRIES = 2;
+
+Fetcher::Fetcher(const QStringList &files, QObject *parent) :
+    QObject(parent),
+    mFiles(files),
+    mTransfer(nullptr),
+    mAttempts(0),
+    mOk(true)
+{
+    QTimer::singleShot(0, this, &Fetcher::next);
+}
+
+QDir Fetcher::ready()
+{
+    QDir res = FS::cache().absoluteFilePath(".ready");
+    if (!res.exists())
+        res.mkpath(res.absolutePath());
+    return res;
+}
+
+void Fetcher::markReady(const QString &file)
+{
+    QFile f(ready().absoluteFilePath(file));
+    f.open(QFile::WriteOnly);
+}
+
+void Fetcher::next()
+{
+    delete mTransfer;
+    mTransfer = nullptr;
+    if (mFiles.isEmpty())
+    {
+        emit finished(mOk);
+        return;
+    }
+    QString file = mFiles.first();
+    QSettings r(FS::cache().absoluteFilePath("main.wwrepo"), QSettings::IniFormat);
+    r.beginGroup("Files");
+    r.beginGroup(file);
+    mAttempts = 0;
+    mTransfer = new Transfer(&mNam, r.value("Mirrors").toStringList(), FS::cache().absoluteFilePath(file),
+                             r.value("Sum").toString(), r.value("RE").toStringList(), this);
+    connect(mTransfer, &Transfer::succeeded, this, [this]
+    {
+        markReady(mFiles.takeFirst());
+        QTimer::singleShot(0, this, &Fetcher::next);
+    });
+    connect(mTransfer, &Transfer::failed, this, &Fetcher::failed);
+    mTransfer->start();
+}
+
+void Fetcher::failed()
+{
+    if (++mAttempts < mTransfer->mirrors() * FETCH_RETRIES)
+    {
+        mTransfer->retry();
+        return;
+    }
+    QFile f(ready().absoluteFilePath(mFiles.takeFirst() + ".failed"));
+    f.open(QFile::WriteOnly);
+    mOk = false;
+    QTimer::singleShot(0, this, &Fetcher::next);
+}
@@ -0,0 +1,54 @@
+/***************************************************************************
+ *   Copyright (C) 2016 by Vitalii Kachemtsev <LLIAKAJL@yandex.ru>         *
+ *                                                                         *
+ *   This file is part of Wine Wizard.                                     *
+ *                                                                         *
+ *   Wine Wizard is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   Wine Wizard is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with Wine Wizard.  If not, see <http://www.gnu.org/licenses/>.  *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef FETCHER_H
+#define FETCHER_H
+
+#include <QNetworkAccessManager>
+#include <QStringList>
+#include <QDir>
+
+class Transfer;
+
+class Fetcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit Fetcher(const QStringList &files, QObject *parent = nullptr);
+
+    static QDir ready();
+    static void markReady(const QString &file);
+
+signals:
+    void finished(bool ok);
+
+private:
+    QNetworkAccessManager mNam;
+    QStringList mFiles;
+    Transfer *mTransfer;
+    int mAttempts;
+    bool mOk;
+
+    void next();
+    void failed();
+};
+
+#endif // FETCHER_H
@@ -21,14 +21,153 @@
 #include <QCryptographicHash>
 #include <QDesktopServices>
 #include <QStandardPaths>
+#include <QCoreApplication>
+#include <QDirIterator>
+#include <QThreadPool>
+#include <QDateTime>
+#include <QMutex>
+#include <QHash>
+#include <QRunnable>
+#include <QSharedPointer>
 #include <QThread>
+#include <QUuid>
 #include <QUrl>
 
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+
 #include "filesystem.h"
 #include "waitdialog.h"
 
+const int WINE_PRUNE_GRACE = 3600;
+const int IOPRIO_WHO_PROCESS = 1;
+const int IOPRIO_IDLE = 3 << 13;
+
 namespace FS
 {
+    struct DriveMap
+    {
+        bool built = false;
+        QDateTime stamp;
+        QList<QPair<QString, QChar>> paths;
+        QHash<QChar, QString> targets;
+    };
+
+    static bool gReclaiming = false;
+    static QMutex gDriveLock;
+    static QHash<QString, DriveMap> gDriveMaps;
+
+    static DriveMap driveMap(const QString &prefixHash)
+    {
+        QDateTime stamp = QFileInfo(devices(prefixHash).absolutePath()).lastModified();
+        QMutexLocker locker(&gDriveLock);
+        DriveMap &res = gDriveMaps[prefixHash];
+        if (res.built && res.stamp == stamp)
+            return res;
+        res = DriveMap();
+        res.built = true;
+        res.stamp = stamp;
+        for (char c = 'a'; c <= 'z'; ++c)
+        {
+            QString link = drive(prefixHash, QString(c) + ":").absolutePath();
+            QString target = QFile::symLinkTarget(link);
+            if (target.isEmpty())
+                continue;
+            target = QDir(target).absolutePath();
+            res.targets.insert(QChar(c), target);
+            res.paths.append(qMakePair(target, QChar(c).toUpper()));
+            res.paths.append(qMakePair(link, QChar(c).toUpper()));
+        }
+        std::stable_sort(res.paths.begin(), res.paths.end(), [](const QPair<QString, QChar> &a, const QPair<QString, QChar> &b)
+        {
+            return a.first.length() > b.first.length();
+        });
+        return res;
+    }
+
+    static bool under(const QString &path, const QString &root)
+    {
+        return path.startsWith(root) &&
+               (root.endsWith('/') || path.length() == root.length() || path.at(root.length()) == '/');
+    }
+
+    static void idle()
+    {
+        QThread::currentThread()->setPriority(QThread::IdlePriority);
+        syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, IOPRIO_IDLE);
+    }
+
+    static qint64 removeTree(const QString &path)
+    {
+        qint64 res = 0;
+        QFileInfo info(path);
+        if (!info.isDir() || info.isSymLink())
+        {
+            res = info.isSymLink() ? 0 : info.size();
+            return QFile::remove(path) ? res : 0;
+        }
+        QDirIterator it(path, QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden | QDir::System,
+                        QDirIterator::Subdirectories);
+        while (it.hasNext())
+        {
+            it.next();
+            if (it.fileInfo().isFile() && !it.fileInfo().isSymLink())
+                res += it.fileInfo().size();
+        }
+        QDir(path).removeRecursively();
+        return res;
+    }
+
+    class ReclaimTask : public QRunnable
+    {
+    public:
+        ReclaimTask(const QString &path, QAtomicInteger<qint64> &freed) :
+            mPath(path),
+            mFreed(freed)
+        {
+        }
+
+        void run() override
+        {
+            idle();
+            mFreed.fetchAndAddOrdered(removeTree(mPath));
+        }
+
+    private:
+        QString mPath;
+        QAtomicInteger<qint64> &mFreed;
+    };
+
+    static qint64 reclaimTrash()
+    {
+        idle();
+        QThreadPool pool;
+        pool.setMaxThreadCount(QThread::idealThreadCount());
+        QAtomicInteger<qint64> freed;
+        QDir::Filters filter = QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden | QDir::System;
+        QFileInfoList items = trash().entryInfoList(filter);
+        for (const QFileInfo &item : items)
+        {
+            if (!item.isDir() || item.isSymLink())
+                continue;
+            for (const QFileInfo &sub : QDir(item.absoluteFilePath()).entryInfoList(filter))
+            {
+                if (!sub.isDir() || sub.isSymLink())
+                    pool.start(new ReclaimTask(sub.absoluteFilePath(), freed));
+                else
+                    for (const QFileInfo &subtree : QDir(sub.absoluteFilePath()).entryInfoList(filter))
+                        pool.start(new ReclaimTask(subtree.absoluteFilePath(), freed));
+            }
+        }
+        pool.waitForDone();
+        qint64 res = freed.load();
+        for (const QFileInfo &item : items)
+            res += removeTree(item.absoluteFilePath());
+        pruneWines();
+        return res;
+    }
+
     QDir make(const QString &path)
     {
         QDir res(path);
@@ -39,17 +178,20 @@ namespace FS
 
     QDir cache()
     {
-        return make(QStandardPaths::writableLocation(QStandardPaths::CacheLocation));
+        static const QString path = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+        return make(path);
     }
 
     QDir data()
     {
-        return make(QStandardPaths::writableLocation(QStandardPaths::DataLocation));
+        static const QString path = QStandardPaths::writableLocation(QStandardPaths::DataLocation);
+        return make(path);
     }
 
     QDir config()
     {
-        return make(QDir(QStandardPaths::writableLocation(QStandardPaths::ConfigLocation)).absoluteFilePath("winewizard"));
+        static const QString path = QDir(QStandardPaths::writableLocation(QStandardPaths::ConfigLocation)).absoluteFilePath("winewizard");
+        return make(path);
     }
 
     QDir temp()
@@ -57,6 +199,26 @@ namespace FS
         return make(QDir::temp().absoluteFilePath(".winewizard"));
     }
 
+    QDir shaders()
+    {
+        return make(data().absoluteFilePath(".shaders"));
+    }
+
+    QDir wines()
+    {
+        return make(data().absoluteFilePath(".wines"));
+    }
+
+    QDir layers()
+    {
+        return make(data().absoluteFilePath(".layers"));
+    }
+
+    QDir trash()
+    {
+        return make(data().absoluteFilePath(".trash"));
+    }
+
     QDir prefix(const QString &prefixHash)
     {
         return data().absoluteFilePath(prefixHash);
@@ -107,6 +269,11 @@ namespace FS
         return prefix(prefixHash).absoluteFilePath(".packages");
     }
 
+    QDir logs(const QString &prefixHash)
+    {
+        return make(prefix(prefixHash).absoluteFilePath(".logs"));
+    }
+
     QDir windows(const QString &prefixHash)
     {
         return drive(prefixHash).absoluteFilePath("windows");
@@ -185,21 +352,91 @@ namespace FS
         return res;
     }
 
-    void removePrefix(const QString &prefixHash, QWidget *parent)
+    QMap<QString, int> wineRefs()
+    {
+        QMap<QString, int> res;
+        QDir store = wines();
+        QString root = store.canonicalPath() + '/';
+        for (const QString &build : store.entryList(QDir::Dirs | QDir::NoDotAndDotDot))
+            res.insert(build, 0);
+        for (const QString &hash : data().entryList(QDir::AllDirs | QDir::NoDotAndDotDot | QDir::Hidden))
+        {
+            QString target = QFileInfo(wine(hash).absolutePath()).canonicalFilePath();
+            if (target.startsWith(root))
+                ++res[target.mid(root.length()).section('/', 0, 0)];
+        }
+        return res;
+    }
+
+    void pruneWines()
+    {
+        QDir store = wines();
+        QDateTime grace = QDateTime::currentDateTime().addSecs(-WINE_PRUNE_GRACE);
+        QMap<QString, int> refs = wineRefs();
+        for (QMap<QString, int>::const_iterator it = refs.cbegin(); it != refs.cend(); ++it)
+        {
+            QFileInfo info(store.absoluteFilePath(it.key()));
+            if (it.value() == 0 && !it.key().endsWith(".part") && info.lastModified() < grace)
+                QDir(info.absoluteFilePath()).removeRecursively();
+        }
+    }
+
+    void discard(const QString &path)
     {
-        WaitDialog wd(parent);
+        QDir p(path);
+        if (!p.exists())
+            return;
+        QString target = trash().absoluteFilePath(p.dirName() + '-' + QUuid::createUuid().toString().mid(1, 8));
+        if (!QDir().rename(p.absolutePath(), target))
+            p.removeRecursively();
+    }
+
+    void removePrefix(const QString &prefixHash)
+    {
+        discard(prefix(prefixHash).absolutePath());
+    }
+
+    void reclaim(const std::function<void (qint64)> &done)
+    {
+        QDir::Filters filter = QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden | QDir::System;
+        QStringList before = trash().entryList(filter);
+        if (gReclaiming || before.isEmpty())
+            return;
+        gReclaiming = true;
+        QSharedPointer<qint64> freed(new qint64(0));
         QObject *worker = new QObject;
         worker->moveToThread(new QThread);
-        wd.connect(worker->thread(), &QThread::started, worker, [worker, prefixHash]()
+        QObject::connect(worker->thread(), &QThread::started, worker, [worker, freed]()
         {
-            prefix(prefixHash).removeRecursively();
+            *freed = reclaimTrash();
             worker->deleteLater();
         });
-        wd.connect(worker, &QObject::destroyed, worker->thread(), &QThread::quit);
-        wd.connect(worker->thread(), &QThread::finished, worker->thread(), &QThread::deleteLater);
-        wd.connect(worker->thread(), &QThread::destroyed, &wd, &WaitDialog::accept);
-        worker->thread()->start();
-        wd.exec();
+        QObject::connect(worker, &QObject::destroyed, worker->thread(), &QThread::quit);
+        QObject::connect(worker->thread(), &QThread::finished, worker->thread(), &QThread::deleteLater);
+        QObject::connect(worker->thread(), &QThread::finished, qApp, [done, freed, before, filter]()
+        {
+            gReclaiming = false;
+            QStringList after = trash().entryList(filter), stuck;
+            bool added = false;
+            for (const QString &entry : after)
+                if (before.contains(entry))
+                    stuck.append(entry);
+                else
+                    added = true;
+            if (added || (*freed > 0 && !stuck.isEmpty()))
+                reclaim(done);
+            else
+                for (const QString &entry : stuck)
+                    qWarning("Cannot reclaim %s", qPrintable(trash().absoluteFilePath(entry)));
+            if (done)
+                done(*freed);
+        });
+        worker->thread()->start(QThread::IdlePriority);
+    }
+
+    bool reclaiming()
+    {
+        return gReclaiming;
     }
 
     QString toWinPath(const QString &prefixHash, const QString &path)
@@ -207,22 +444,13 @@ namespace FS
         QString res(path);
         if (res.contains('/'))
         {
-            for (char c = 'a'; c <= 'z'; ++c)
-            {
-                QString targetDrivePath = driveTarget(prefixHash, QString(c) + ":").absolutePath();
-                QString drivePath = FS::drive(prefixHash, QString(c) + ":").absolutePath();
-                QString driveLetter = QString(QChar::toUpper(c)) + ":/";
-                if (res.startsWith(targetDrivePath))
+            DriveMap map = driveMap(prefixHash);
+            for (const QPair<QString, QChar> &entry : map.paths)
+                if (under(res, entry.first))
                 {
-                    res.replace(0, targetDrivePath.length(), driveLetter);
+                    res.replace(0, entry.first.length(), QString(entry.second) + ":/");
                     break;
                 }
-                else if (res.startsWith(drivePath))
-                {
-                    res.replace(0, drivePath.length(), driveLetter);
-                    break;
-                }
-            }
             return res.replace("//", "/").replace('/', '\\');
         }
         return res;
@@ -234,16 +462,16 @@ namespace FS
         if (res.contains('\\'))
         {
             res.replace('\\', '/');
-            for (char c = 'a'; c <= 'z'; ++c)
-                if (res.startsWith(QString(c) + ":/") || res.startsWith(QString(QChar::toUpper(c)) + ":/"))
+            if (res.length() >= 3 && res.at(1) == ':' && res.at(2) == '/')
+            {
+                QString target = driveMap(prefixHash).targets.value(res.at(0).toLower());
+                if (!target.isEmpty())
                 {
-                    QString driveLetter = QString(QChar(res.at(0)).toLower()) + ":";
-                    QString target = FS::driveTarget(prefixHash, driveLetter).absolutePath();
                     if (!target.endsWith('/'))
                         target += '/';
                     res.replace(0, 3, target);
-                    break;
                 }
+            }
         }
         return res;
     }
@@ -21,7 +21,10 @@
 #ifndef FILESYSTEM_H
 #define FILESYSTEM_H
 
+#include <functional>
+
 #include <QDir>
+#include <QMap>
 
 namespace FS
 {
@@ -29,6 +32,10 @@ namespace FS
     QDir data();
     QDir config();
     QDir temp();
+    QDir shaders();
+    QDir wines();
+    QDir layers();
+    QDir trash();
 
     QDir prefix(const QString &prefixHash);
     QDir devices(const QString &prefixHash);
@@ -40,6 +47,7 @@ namespace FS
     QDir documents(const QString &prefixHash);
     QDir wine(const QString &prefixHash);
     QDir packages(const QString &prefixHash);
+    QDir logs(const QString &prefixHash);
     QDir windows(const QString &prefixHash);
     QDir sys32(const QString &prefixHash, const QString &arch = "32");
     QDir sys64(const QString &prefixHash);
@@ -51,7 +59,12 @@ namespace FS
     QString hash(const QString &str);
     bool checkFileSum(const QString &filePath, const QString &checksum);
 
-    void removePrefix(const QString &prefixHash, QWidget *parent = nullptr);
+    QMap<QString, int> wineRefs();
+    void pruneWines();
+    void discard(const QString &path);
+    void removePrefix(const QString &prefixHash);
+    void reclaim(const std::function<void (qint64)> &done = nullptr);
+    bool reclaiming();
     QString toWinPath(const QString &prefixHash, const QString &path);
     QString toUnixPath(const QString &prefixHash, const QString &path);
 }
@@ -0,0 +1,360 @@
+/***************************************************************************
+ *   Copyright (C) 2016 by Vitalii Kachemtsev <LLIAKAJL@yandex.ru>         *
+ *                                                                         *
+ *   This file is part of Wine Wizard.                                     *
+ *                                                                         *
+ *   Wine Wizard is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   Wine Wizard is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with Wine Wizard.  If not, see <http://www.gnu.org/licenses/>.  *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QApplication>
+#include <QSettings>
+
+#include "filesystem.h"
+#include "installer.h"
+#include "templates.h"
+#include "fetcher.h"
+#include "launcher.h"
+
+Installer::Installer(const QString &prefixName, const QString &arch, const QString &wine, const QString &bs,
+                     const QString &acs, const QString &as, QObject *parent) :
+    QObject(parent),
+    mPrefixName(prefixName),
+    mPrefixHash(FS::hash(prefixName)),
+    mArch(arch),
+    mWine(wine),
+    mBs(bs),
+    mAcs(acs),
+    mAs(as),
+    mFetched(0),
+    mResume(false),
+    mCloned(false),
+    mPackagesFailed(false)
+{
+}
+
+const QString &Installer::prefixHash() const
+{
+    return mPrefixHash;
+}
+
+const Ex::Log &Installer::log() const
+{
+    return mLog;
+}
+
+const Ex::Analyzer &Installer::analyzer() const
+{
+    return mAnalyzer;
+}
+
+void Installer::start(const QString &exe, const QString &workDir, const QString &args, const QStringList &pending,
+                      const QString &solution, bool resume)
+{
+    mClock.start();
+    mResume = resume;
+    if (!mResume)
+    {
+        QDir prefix = FS::prefix(mPrefixHash);
+        prefix.mkpath(prefix.absolutePath());
+        QFile f(prefix.absoluteFilePath(".journal"));
+        if (f.open(QFile::WriteOnly | QFile::Truncate))
+            f.write(("solution " + solution + '\n').toUtf8());
+    }
+    if (!pending.isEmpty())
+    {
+        Fetcher *fetcher = new Fetcher(pending, this);
+        connect(fetcher, &Fetcher::finished, this, [this, fetcher]
+        {
+            mFetched = mClock.elapsed();
+            fetcher->deleteLater();
+        });
+    }
+    mExe = exe;
+    mWorkDir = workDir;
+    mArgs = args;
+    Ex::invalidate(mPrefixHash);
+    if (mResume && journaled("wine"))
+        wineInstalled(nullptr);
+    else
+    {
+        Ex::Job *job = Ex::start(Ex::Job::Terminal, mBs, mPrefixHash);
+        connect(job, &Ex::Job::finished, this, &Installer::wineInstalled);
+    }
+}
+
+void Installer::setManifest(const QVariantMap &manifest)
+{
+    mManifest = manifest;
+}
+
+bool Installer::updatable(const QString &prefixHash, const QVariantMap &manifest)
+{
+    QDir prefix = FS::prefix(prefixHash);
+    if (!FS::readFile(prefix.absoluteFilePath(".journal")).split('\n').contains("done"))
+        return false;
+    QSettings s(prefix.absoluteFilePath(".settings"), QSettings::IniFormat);
+    s.setIniCodec("UTF-8");
+    s.beginGroup("Manifest");
+    if (s.value("Arch").toString() != manifest.value("Arch").toString())
+        return false;
+    QStringList packages = manifest.value("BP").toStringList() + manifest.value("AP").toStringList();
+    for (const QString &p : s.value("BP").toStringList() + s.value("AP").toStringList())
+        if (!packages.contains(p))
+            return false;
+    return true;
+}
+
+bool Installer::update(const QString &prefixHash, const QString &solution, const QVariantMap &manifest)
+{
+    if (!updatable(prefixHash, manifest))
+        return false;
+    QDir prefix = FS::prefix(prefixHash);
+    QStringList steps = FS::readFile(prefix.absoluteFilePath(".journal")).split('\n', QString::SkipEmptyParts);
+    QSettings s(prefix.absoluteFilePath(".settings"), QSettings::IniFormat);
+    s.setIniCodec("UTF-8");
+    s.beginGroup("Manifest");
+    QStringList res;
+    res.append("solution " + solution);
+    if (s.value("BW").toString() == manifest.value("BW").toString() &&
+        s.value("AW").toString() == manifest.value("AW").toString())
+        res.append("wine");
+    res.append("prefix");
+    if (s.value("Exe").toString() == manifest.value("Exe").toString())
+        res.append("application");
+    for (const QString &step : steps)
+        if (step.startsWith("step "))
+            res.append(step);
+    s.endGroup();
+    QFile f(prefix.absoluteFilePath(".journal"));
+    if (!f.open(QFile::WriteOnly | QFile::Truncate))
+        return false;
+    f.write((res.join('\n') + '\n').toUtf8());
+    return true;
+}
+
+bool Installer::resumable(const QString &prefixHash, const QString &solution)
+{
+    QStringList steps = FS::readFile(FS::prefix(prefixHash).absoluteFilePath(".journal")).split('\n', QString::SkipEmptyParts);
+    return !steps.isEmpty() && steps.first() == "solution " + solution && !steps.contains("done");
+}
+
+void Installer::wineInstalled(Ex::Job *job)
+{
+    if (qApp->property("Quit").toBool())
+    {
+        emit finished(this);
+        return;
+    }
+    mark(tr("Wine"));
+    if (job && job->exitCode() == 0)
+        journal("wine");
+    Ex::invalidate(mPrefixHash);
+    QSettings sol(FS::prefix(mPrefixHash).absoluteFilePath(".settings"), QSettings::IniFormat);
+    sol.setIniCodec("UTF-8");
+    sol.setValue("Name", mPrefixName);
+    if (mResume && journaled("prefix"))
+    {
+        templateSaved();
+        return;
+    }
+    QDir prefix = FS::prefix(mPrefixHash);
+    if (mResume)
+        restart();
+    QString script = FS::readFile(":/create");
+    QProcessEnvironment overlay;
+    bool vacant = Templates::vacant(prefix);
+    mCloned = true;
+    if (vacant && Templates::take(mWine, mArch, prefix))
+        script.clear();
+    else if (vacant && Templates::exists(mWine, mArch))
+    {
+        script = FS::readFile(":/clone");
+        overlay.insert("WW_TEMPLATE", Templates::path(mWine, mArch));
+    }
+    else
+        mCloned = false;
+    Ex::Job *job = Ex::start(Ex::Job::Release, script + FS::readFile(":/fixup"), mPrefixHash, overlay);
+    connect(job, &Ex::Job::finished, this, &Installer::prefixCreated);
+}
+
+void Installer::prefixCreated(Ex::Job *job)
+{
+    if (qApp->property("Quit").toBool())
+    {
+        emit finished(this);
+        return;
+    }
+    bool created = mCloned || journaled("created");
+    if (job->exitCode() == 0 && created)
+        journal("prefix");
+    QString wmbPath = FS::sys32(mPrefixHash, mArch).absoluteFilePath("winemenubuilder.exe");
+    QFile::remove(wmbPath);
+    QFile::copy(":/winemenubuilder.exe", wmbPath);
+    if (mArch == "64")
+    {
+        wmbPath = FS::sys64(mPrefixHash).absoluteFilePath("winemenubuilder.exe");
+        QFile::remove(wmbPath);
+        QFile::copy(":/winemenubuilder64.exe", wmbPath);
+    }
+    if (!created || Templates::exists(mWine, mArch))
+        templateSaved();
+    else
+    {
+        QProcessEnvironment overlay;
+        overlay.insert("WW_TEMPLATE", Templates::path(mWine, mArch));
+        Ex::Job *job = Ex::start(Ex::Job::Release, FS::readFile(":/snapshot"), mPrefixHash, overlay);
+        connect(job, &Ex::Job::finished, this, &Installer::templateSaved);
+    }
+}
+
+void Installer::templateSaved()
+{
+    if (qApp->property("Quit").toBool())
+    {
+        emit finished(this);
+        return;
+    }
+    mark(tr("Prefix"));
+    if (mAcs.isEmpty())
+        packagesInstalled(nullptr);
+    else
+    {
+        Ex::Job *job = Ex::start(Ex::Job::Terminal, mAcs, mPrefixHash, overlay());
+        connect(job, &Ex::Job::finished, this, &Installer::packagesInstalled);
+    }
+}
+
+void Installer::packagesInstalled(Ex::Job *job)
+{
+    if (qApp->property("Quit").toBool())
+    {
+        emit finished(this);
+        return;
+    }
+    mark(tr("Packages"));
+    mPackagesFailed = job && job->exitCode() != 0;
+    if (mResume && journaled("application"))
+    {
+        applicationInstalled(nullptr);
+        return;
+    }
+    Ex::Job *appJob = Ex::launch(Ex::Job::Debug, mExe, mWorkDir, mArgs, mPrefixHash);
+    connect(appJob, &Ex::Job::finished, this, &Installer::applicationInstalled);
+}
+
+void Installer::applicationInstalled(Ex::Job *job)
+{
+    if (qApp->property("Quit").toBool())
+    {
+        emit finished(this);
+        return;
+    }
+    if (job)
+    {
+        mLog = job->log();
+        mAnalyzer = job->analyzer();
+        if (job->exitCode() == 0)
+            journal("application");
+    }
+    mark(tr("Application"));
+    Ex::Job *asJob = Ex::start(Ex::Job::Terminal, timeline() + mAs, mPrefixHash, overlay());
+    connect(asJob, &Ex::Job::finished, this, &Installer::finish);
+}
+
+void Installer::finish(Ex::Job *job)
+{
+    if (!mPackagesFailed && job->exitCode() == 0)
+    {
+        journal("done");
+        QSettings s(FS::prefix(mPrefixHash).absoluteFilePath(".settings"), QSettings::IniFormat);
+        s.setIniCodec("UTF-8");
+        s.beginGroup("Manifest");
+        s.remove("");
+        for (QVariantMap::const_iterator it = mManifest.cbegin(); it != mManifest.cend(); ++it)
+            s.setValue(it.key(), it.value());
+        s.endGroup();
+        s.sync();
+    }
+    Ex::invalidate(mPrefixHash);
+    Launcher::update(mPrefixHash);
+    emit finished(this);
+}
+
+void Installer::restart()
+{
+    QDir prefix = FS::prefix(mPrefixHash);
+    Templates::clear(prefix);
+    QStringList steps;
+    for (const QString &step : FS::readFile(prefix.absoluteFilePath(".journal")).split('\n', QString::SkipEmptyParts))
+        if (step.startsWith("solution ") || step == "wine")
+            steps.append(step);
+    QFile f(prefix.absoluteFilePath(".journal"));
+    if (f.open(QFile::WriteOnly | QFile::Truncate))
+        f.write((steps.join('\n') + '\n').toUtf8());
+    mResume = false;
+}
+
+void Installer::journal(const QString &step) const
+{
+    QFile f(FS::prefix(mPrefixHash).absoluteFilePath(".journal"));
+    if (f.open(QFile::Append))
+        f.write((step + '\n').toUtf8());
+}
+
+bool Installer::journaled(const QString &step) const
+{
+    return FS::readFile(FS::prefix(mPrefixHash).absoluteFilePath(".journal")).split('\n').contains(step);
+}
+
+QProcessEnvironment Installer::overlay() const
+{
+    QProcessEnvironment res;
+    if (mResume)
+        res.insert("WW_RESUME", "1");
+    return res;
+}
+
+void Installer::mark(const QString &phase)
+{
+    mMarks.append(qMakePair(phase, mClock.elapsed()));
+}
+
+QString Installer::timeline() const
+{
+    qint64 waited = 0;
+    for (const QString &line : FS::readFile(Fetcher::ready().absoluteFilePath(".waited")).split('\n', QString::SkipEmptyParts))
+        waited += line.toLongLong() * 1000;
+    QString res;
+    QString critical;
+    qint64 longest = -1, prev = 0;
+    for (const QPair<QString, qint64> &m : mMarks)
+    {
+        qint64 duration = m.second - prev;
+        res += QString("echo '%1: %2 s (done at %3 s)'\n").arg(m.first).arg(duration / 1000.0, 0, 'f', 1)
+                                                         .arg(m.second / 1000.0, 0, 'f', 1);
+        if (duration > longest)
+        {
+            longest = duration;
+            critical = m.first;
+        }
+        prev = m.second;
+    }
+    if (mFetched > 0)
+        res += QString("echo '%1: done at %2 s, %3 s spent waiting'\n").arg(tr("Downloads"))
+                   .arg(mFetched / 1000.0, 0, 'f', 1).arg(waited / 1000.0, 0, 'f', 1);
+    if (!critical.isEmpty())
+        res += QString("echo '%1: %2'\n").arg(tr("Critical path")).arg(critical);
+    return res;
+}
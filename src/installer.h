@@ -0,0 +1,78 @@
+/***************************************************************************
+ *   Copyright (C) 2016 by Vitalii Kachemtsev <LLIAKAJL@yandex.ru>         *
+ *                                                                         *
+ *   This file is part of Wine Wizard.                                     *
+ *                                                                         *
+ *   Wine Wizard is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   Wine Wizard is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with Wine Wizard.  If not, see <http://www.gnu.org/licenses/>.  *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef INSTALLER_H
+#define INSTALLER_H
+
+#include <QElapsedTimer>
+
+#include "executor.h"
+
+class Installer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit Installer(const QString &prefixName, const QString &arch, const QString &wine, const QString &bs,
+                       const QString &acs, const QString &as, QObject *parent = nullptr);
+
+    const QString &prefixHash() const;
+    const Ex::Log &log() const;
+    const Ex::Analyzer &analyzer() const;
+    void start(const QString &exe, const QString &workDir, const QString &args,
+               const QStringList &pending = QStringList(), const QString &solution = QString(), bool resume = false);
+
+    void setManifest(const QVariantMap &manifest);
+
+    static bool resumable(const QString &prefixHash, const QString &solution);
+    static bool updatable(const QString &prefixHash, const QVariantMap &manifest);
+    static bool update(const QString &prefixHash, const QString &solution, const QVariantMap &manifest);
+
+signals:
+    void finished(Installer *installer);
+
+private:
+    QString mPrefixName, mPrefixHash, mArch, mWine, mBs, mAcs, mAs, mExe, mWorkDir, mArgs;
+    Ex::Log mLog;
+    Ex::Analyzer mAnalyzer;
+    QVariantMap mManifest;
+    QElapsedTimer mClock;
+    QList<QPair<QString, qint64>> mMarks;
+    qint64 mFetched;
+    bool mResume;
+    bool mCloned;
+    bool mPackagesFailed;
+
+    void mark(const QString &phase);
+    void restart();
+    void journal(const QString &step) const;
+    bool journaled(const QString &step) const;
+    QProcessEnvironment overlay() const;
+    QString timeline() const;
+
+    void wineInstalled(Ex::Job *job);
+    void prefixCreated(Ex::Job *job);
+    void templateSaved();
+    void packagesInstalled(Ex::Job *job);
+    void applicationInstalled(Ex::Job *job);
+    void finish(Ex::Job *job);
+};
+
+#endif // INSTALLER_H
@@ -0,0 +1,150 @@
+/***************************************************************************
+ *   Copyright (C) 2016 by Vitalii Kachemtsev <LLIAKAJL@yandex.ru>         *
+ *                                                                         *
+ *   This file is part of Wine Wizard.                                     *
+ *                                                                         *
+ *   Wine Wizard is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   Wine Wizard is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with Wine Wizard.  If not, see <http://www.gnu.org/licenses/>.  *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QStandardPaths>
+#include <QSettings>
+
+#include "shadercache.h"
+#include "filesystem.h"
+#include "executor.h"
+#include "launcher.h"
+
+const QString DESKTOP_ENTRY = "[Desktop Entry]\nType=Application\nName=%1\nExec=%2\nPath=%3\nIcon=%4\n" \
+                              "Terminal=false\nCategories=Wine;\n";
+
+namespace Launcher
+{
+    QString quote(const QString &str)
+    {
+        return '\'' + QString(str).replace('\'', "'\\''") + '\'';
+    }
+
+    QDir scripts(const QString &prefixHash)
+    {
+        QDir res(FS::shortcuts(prefixHash).absoluteFilePath(".launchers"));
+        if (!res.exists())
+            res.mkpath(res.absolutePath());
+        return res;
+    }
+
+    QDir applications()
+    {
+        QDir res(QStandardPaths::writableLocation(QStandardPaths::ApplicationsLocation));
+        if (!res.exists())
+            res.mkpath(res.absolutePath());
+        return res;
+    }
+
+    QString desktopName(const QString &prefixHash, const QString &shortcutHash)
+    {
+        return "winewizard-" + prefixHash + '-' + shortcutHash + ".desktop";
+    }
+
+    void write(const QString &prefixHash, const QString &shortcutHash)
+    {
+        QSettings s(FS::shortcuts(prefixHash).absoluteFilePath(shortcutHash), QSettings::IniFormat);
+        s.setIniCodec("UTF-8");
+        QString name = s.value("Name").toString();
+        QString exe = FS::toUnixPath(prefixHash, s.value("Exe").toString());
+        QString workDir = FS::toUnixPath(prefixHash, s.value("WorkDir").toString());
+        if (workDir.isEmpty())
+            workDir = QFileInfo(exe).absolutePath();
+        QProcessEnvironment sys = QProcessEnvironment::systemEnvironment();
+        QProcessEnvironment e = Ex::env(prefixHash, Ex::overlay(Ex::presets(s, false)), exe);
+        QString script = "#!/bin/sh\n";
+        QStringList keys = e.keys();
+        keys.sort();
+        for (const QString &key : keys)
+        {
+            QString value = e.value(key);
+            QString old = sys.value(key);
+            if (sys.contains(key) && value == old)
+                continue;
+            if (!old.isEmpty() && value.endsWith(old) && (key == "PATH" || key == "LD_LIBRARY_PATH"))
+                script += "export " + key + '=' + quote(value.left(value.length() - old.length())) + "\"$" + key + "\"\n";
+            else
+                script += "export " + key + '=' + quote(value) + '\n';
+        }
+        bool quiet = e.value("WW_QUIET", "1") == "1";
+        if (quiet && (!e.contains("WINEDEBUG") || e.value("WINEDEBUG") == sys.value("WINEDEBUG")))
+            script += "export WINEDEBUG=-all\n";
+        QString stamp = Shaders::stamp(exe);
+        if (!stamp.isEmpty())
+        {
+            script += "mkdir -p";
+            for (const QString &dir : Shaders::dirs(exe))
+                script += ' ' + quote(dir);
+            script += " 2>/dev/null\ntouch " + quote(stamp) + " 2>/dev/null\n";
+        }
+        script += "cd " + quote(workDir) + " || exit 1\n";
+        script += "exec";
+        for (const QString &arg : Ex::wrapper(prefixHash))
+            script += ' ' + quote(arg);
+        script += ' ' + quote(e.value("WINELOADER"));
+        QString suffix = QFileInfo(exe).suffix().toLower();
+        if (!QSettings("winewizard", "settings").value("DirectLaunch", true).toBool() ||
+            (suffix != "exe" && suffix != "msi"))
+            script += " start /wait /Unix " + quote(exe);
+        else if (suffix == "msi")
+            script += " msiexec /i " + quote(FS::toWinPath(prefixHash, exe));
+        else
+            script += ' ' + quote(exe);
+        for (const QString &arg : Ex::splitArgs(s.value("Args").toString()))
+            script += ' ' + quote(arg);
+        script += " \"$@\"\n";
+        QString scriptPath = scripts(prefixHash).absoluteFilePath(shortcutHash);
+        QFile f(scriptPath);
+        if (!f.open(QFile::WriteOnly | QFile::Truncate))
+            return;
+        f.write(script.toLocal8Bit());
+        f.close();
+        f.setPermissions(f.permissions() | QFile::ExeOwner | QFile::ExeUser);
+        QDir iDir = FS::icons(prefixHash);
+        QString icon = iDir.exists(shortcutHash) ? iDir.absoluteFilePath(shortcutHash) : "winewizard";
+        QString exec = '"' + QString(scriptPath).replace('\\', "\\\\").replace('"', "\\\"")
+                                                .replace('`', "\\`").replace('$', "\\$") + '"';
+        QFile d(applications().absoluteFilePath(desktopName(prefixHash, shortcutHash)));
+        if (d.open(QFile::WriteOnly | QFile::Truncate))
+            d.write(DESKTOP_ENTRY.arg(name).arg(exec).arg(workDir).arg(icon).toUtf8());
+    }
+
+    void remove(const QString &prefixHash, const QString &shortcutHash)
+    {
+        scripts(prefixHash).remove(shortcutHash);
+        applications().remove(desktopName(prefixHash, shortcutHash));
+    }
+
+    void update(const QString &prefixHash)
+    {
+        removeAll(prefixHash);
+        for (const QString &shortcutHash : FS::shortcuts(prefixHash).entryList(QDir::Files | QDir::Hidden))
+            write(prefixHash, shortcutHash);
+    }
+
+    void removeAll(const QString &prefixHash)
+    {
+        QDir apps = applications();
+        for (const QString &entry : apps.entryList(QStringList("winewizard-" + prefixHash + "-*.desktop"), QDir::Files))
+            apps.remove(entry);
+        QDir dir(FS::shortcuts(prefixHash).absoluteFilePath(".launchers"));
+        if (dir.exists())
+            dir.removeRecursively();
+    }
+}
@@ -0,0 +1,167 @@
+/***************************************************************************
+ *   Copyright (C) 2016 by Vitalii Kachemtsev <LLIAKAJL@yandex.ru>         *
+ *                                                                         *
+ *   This file is part of Wine Wizard.                                     *
+ *                                                                         *
+ *   Wine Wizard is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   Wine Wizard is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with Wine Wizard.  If not, see <http://www.gnu.org/licenses/>.  *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QFileInfo>
+#include <QDateTime>
+#include <QSettings>
+
+#include "loganalyzer.h"
+#include "filesystem.h"
+
+const int MAX_ADVICE_CHANNELS = 10;
+
+LogAnalyzer::LogAnalyzer(RunLog *log, QObject *parent) :
+    QObject(parent),
+    mErrors(loadErrors())
+{
+    mTimer.start();
+    connect(log, &RunLog::appended, this, &LogAnalyzer::appended);
+}
+
+QStringList LogAnalyzer::packages() const
+{
+    return mPackages;
+}
+
+const LogAnalyzer::ChannelMap &LogAnalyzer::channels() const
+{
+    return mChannels;
+}
+
+QStringList LogAnalyzer::advice() const
+{
+    QStringList res;
+    QStringList packages = mPackages;
+    packages.sort();
+    for (const QString &package : packages)
+        res.append(tr("You can try to install package: %1.").arg(package));
+    if (res.isEmpty())
+        res.append(tr("You can try to change the version of Wine."));
+    QList<QPair<int, QString>> top;
+    for (ChannelMap::const_iterator i = mChannels.begin(); i != mChannels.end(); ++i)
+        top.append(qMakePair(i.value().errors * 1000 + i.value().fixmes, i.key()));
+    if (!top.isEmpty())
+    {
+        qSort(top.begin(), top.end(), [](const QPair<int, QString> &l, const QPair<int, QString> &r)
+        {
+            return l.first > r.first;
+        });
+        res.append(QString());
+        res.append(tr("Messages by channel:"));
+        for (int i = 0; i < top.count() && i < MAX_ADVICE_CHANNELS; ++i)
+        {
+            const Channel &c = mChannels[top.at(i).second];
+            res.append(tr("%1: %2 err, %3 fixme, first at %4 s").arg(top.at(i).second).arg(c.errors)
+                       .arg(c.fixmes).arg(c.firstSeen / 1000.0, 0, 'f', 1));
+        }
+    }
+    return res;
+}
+
+void LogAnalyzer::finish()
+{
+    if (!mRest.isEmpty() && parse(mRest))
+        emit changed();
+    mRest.clear();
+}
+
+void LogAnalyzer::appended(RunLog::Channel channel, const QByteArray &data)
+{
+    if (channel != RunLog::Err)
+        return;
+    mRest.append(data);
+    bool update = false;
+    int start = 0;
+    for (int end = mRest.indexOf('\n'); end >= 0; end = mRest.indexOf('\n', start))
+    {
+        update |= parse(QByteArray::fromRawData(mRest.constData() + start, end - start));
+        start = end + 1;
+    }
+    mRest.remove(0, start);
+    if (update)
+        emit changed();
+}
+
+bool LogAnalyzer::parse(const QByteArray &line)
+{
+    bool res = false;
+    for (ErrorMap::iterator i = mErrors.begin(); i != mErrors.end();)
+    {
+        bool found = false;
+        for (const QByteArray &error : i.value())
+            if (line.contains(error))
+            {
+                found = true;
+                break;
+            }
+        if (found)
+        {
+            mPackages.append(i.key());
+            i = mErrors.erase(i);
+            res = true;
+        }
+        else
+            ++i;
+    }
+    int pos = 0;
+    for (int field = 0; field < 3; ++field)
+    {
+        int colon = line.indexOf(':', pos);
+        if (colon < 0)
+            break;
+        QByteArray cls = line.mid(pos, colon - pos);
+        bool err = cls == "err";
+        if (err || cls == "fixme")
+        {
+            int end = line.indexOf(':', colon + 1);
+            if (end < 0)
+                break;
+            Channel &c = mChannels[QString::fromLatin1(line.mid(colon + 1, end - colon - 1))];
+            if (c.errors == 0 && c.fixmes == 0)
+                c.firstSeen = mTimer.elapsed();
+            if (err)
+                ++c.errors;
+            else
+                ++c.fixmes;
+            return true;
+        }
+        pos = colon + 1;
+    }
+    return res;
+}
+
+LogAnalyzer::ErrorMap LogAnalyzer::loadErrors()
+{
+    static ErrorMap errors;
+    static QDateTime modified;
+    QFileInfo repo(FS::cache().absoluteFilePath("main.wwrepo"));
+    if (repo.lastModified() != modified)
+    {
+        modified = repo.lastModified();
+        errors.clear();
+        QSettings r(repo.absoluteFilePath(), QSettings::IniFormat);
+        r.beginGroup("Errors");
+        for (const QString &package : r.childGroups())
+            for (const QString &error : r.value(package + "/RE").toStringList())
+                errors[package].append(error.toUtf8());
+        r.endGroup();
+    }
+    return errors;
+}
@@ -0,0 +1,66 @@
+/***************************************************************************
+ *   Copyright (C) 2016 by Vitalii Kachemtsev <LLIAKAJL@yandex.ru>         *
+ *                                                                         *
+ *   This file is part of Wine Wizard.                                     *
+ *                                                                         *
+ *   Wine Wizard is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   Wine Wizard is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with Wine Wizard.  If not, see <http://www.gnu.org/licenses/>.  *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef LOGANALYZER_H
+#define LOGANALYZER_H
+
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QMap>
+
+#include "runlog.h"
+
+class LogAnalyzer : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Channel
+    {
+        int errors, fixmes;
+        qint64 firstSeen;
+    };
+    typedef QMap<QString, Channel> ChannelMap;
+
+    explicit LogAnalyzer(RunLog *log, QObject *parent = nullptr);
+
+    QStringList packages() const;
+    const ChannelMap &channels() const;
+    QStringList advice() const;
+    void finish();
+
+signals:
+    void changed();
+
+private:
+    typedef QMap<QString, QList<QByteArray>> ErrorMap;
+
+    ErrorMap mErrors;
+    QStringList mPackages;
+    ChannelMap mChannels;
+    QByteArray mRest;
+    QElapsedTimer mTimer;
+
+    void appended(RunLog::Channel channel, const QByteArray &data);
+    bool parse(const QByteArray &line);
+    static ErrorMap loadErrors();
+};
+
+#endif // LOGANALYZER_H
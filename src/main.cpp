@@ -23,10 +23,13 @@
 #include <QDir>
 
 #include "qtsingleapplication/QtSingleApplication"
+#include "extractor.h"
 #include "wizard.h"
 
 int main(int argc, char *argv[])
 {
+    if (argc == 4 && QString(argv[1]) == "--extract")
+        return Extractor::run(QFile::decodeName(argv[2]), QFile::decodeName(argv[3]));
     QtSingleApplication app(argc, argv);
     QStringList list = app.arguments();
     list.removeFirst();
@@ -53,7 +56,7 @@ int main(int argc, char *argv[])
     Wizard w(trayVisible, autoclose);
     app.connect(&app, &QtSingleApplication::messageReceived, &w, &Wizard::start);
     w.start(cmdLine);
-    if (!trayVisible || autoclose || app.property("quit").toBool())
+    if ((!trayVisible || autoclose) && w.idle())
         return 0;
     else
         return app.exec();
@@ -23,7 +23,9 @@
 #include <QStyle>
 
 #include "filesystem.h"
+#include "executor.h"
 #include "mainmenu.h"
+#include "process.h"
 
 MainMenu::MainMenu(bool autoclose, const QStringList &runList, const QStringList &busyList, QWidget *parent) :
     QMenu(parent),
@@ -35,6 +37,7 @@ MainMenu::MainMenu(bool autoclose, const QStringList &runList, const QStringList
     act->setEnabled(busyList.isEmpty());
     addSeparator();
     QFileInfoList pList = FS::data().entryInfoList(QDir::AllDirs | QDir::NoDotAndDotDot);
+    bool warm = QSettings("winewizard", "settings").value("Warm/Enabled", false).toBool();
     if (pList.isEmpty())
         addEmpty(this);
     else
@@ -48,8 +51,12 @@ MainMenu::MainMenu(bool autoclose, const QStringList &runList, const QStringList
             QSettings s(FS::prefix(hash).absoluteFilePath(".settings"), QSettings::IniFormat);
             s.setIniCodec("UTF-8");
             QString name = s.value("Name").toString();
-            QMenu *pMenu = addMenu(getPrefixIcon(hash), QString(name).replace('&', "&&"));
             bool run = runList.contains(hash);
+            bool suspended = run && Proc::suspended(pInfo.absoluteFilePath());
+            QString title = QString(name).replace('&', "&&");
+            if (suspended)
+                title = tr("%1 (suspended)").arg(title);
+            QMenu *pMenu = addMenu(getPrefixIcon(hash), title);
             bool busyOrRun = busyList.contains(hash) || run;
             if (sList.isEmpty())
                 addEmpty(pMenu);
@@ -69,13 +76,9 @@ MainMenu::MainMenu(bool autoclose, const QStringList &runList, const QStringList
                     act->setProperty("Exe", FS::toUnixPath(hash, s.value("Exe").toString()));
                     act->setProperty("WorkDir", FS::toUnixPath(hash, s.value("WorkDir").toString()));
                     act->setProperty("Args", s.value("Args").toString());
-                    if (s.value("Debug", true).toBool())
-                    {
-                        act->setData(Debug);
-                        act->setProperty("Shortcut", shortcut.absoluteFilePath());
-                    }
-                    else
-                        act->setData(Run);
+                    act->setProperty("Presets", Ex::presets(s, false));
+                    act->setProperty("Shortcut", shortcut.absoluteFilePath());
+                    act->setData(s.value("Debug", true).toBool() ? Debug : Run);
                 }
             }
             pMenu->addSeparator();
@@ -83,6 +86,10 @@ MainMenu::MainMenu(bool autoclose, const QStringList &runList, const QStringList
             act = ccMenu->addAction(style()->standardIcon(QStyle::SP_MediaPlay), tr("Run File"));
             act->setProperty("PrefixHash", hash);
             act->setData(RunFile);
+            act = ccMenu->addAction(style()->standardIcon(QStyle::SP_MediaSeekForward), tr("Run File in Temporary Prefix"));
+            act->setProperty("PrefixHash", hash);
+            act->setData(RunTemp);
+            act->setEnabled(FS::wine(hash).exists());
             act = ccMenu->addAction(style()->standardIcon(QStyle::SP_DirOpenIcon), tr("Browse"));
             act->setProperty("PrefixHash", hash);
             ccMenu->addSeparator();
@@ -96,6 +103,12 @@ MainMenu::MainMenu(bool autoclose, const QStringList &runList, const QStringList
             act->setProperty("PrefixHash", hash);
             act->setProperty("Exe", FS::toUnixPath(hash, "C:\\windows\\regedit.exe"));
             act->setData(Run);
+            act = ccMenu->addAction(tr("Keep Warm"));
+            act->setCheckable(true);
+            act->setChecked(s.value("Warm", false).toBool());
+            act->setEnabled(warm);
+            act->setProperty("PrefixHash", hash);
+            act->setData(Warm);
             act = ccMenu->addAction(style()->standardIcon(QStyle::SP_FileDialogDetailedView), tr("Edit"));
             act->setProperty("PrefixHash", hash);
             act->setData(Edit);
@@ -112,6 +125,27 @@ MainMenu::MainMenu(bool autoclose, const QStringList &runList, const QStringList
             act->setProperty("PrefixHash", hash);
             act->setData(Terminate);
             act->setEnabled(run);
+            if (suspended)
+            {
+                act = pMenu->addAction(style()->standardIcon(QStyle::SP_MediaPlay), tr("Resume"));
+                act->setData(Resume);
+            }
+            else
+            {
+                act = pMenu->addAction(style()->standardIcon(QStyle::SP_MediaPause), tr("Suspend"));
+                act->setData(Suspend);
+                act->setEnabled(run);
+            }
+            act->setProperty("PrefixHash", hash);
+            act = pMenu->addAction(style()->standardIcon(QStyle::SP_FileDialogContentsView), tr("Debug Output"));
+            act->setData(Output);
+            act->setEnabled(false);
+            for (Ex::Job *job : Ex::jobs(hash))
+                if (job->mode() == Ex::Job::Debug)
+                {
+                    act->setProperty("JobId", job->id());
+                    act->setEnabled(true);
+                }
         }
     }
     addSeparator();
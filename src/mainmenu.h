@@ -31,8 +31,8 @@ class MainMenu : public QMenu, public SingletonWidget
     Q_OBJECT
 
 public:
-    enum { Empty, Install, Debug, Run, RunFile, Browse, Delete,
-           Edit, Terminate, Settings, About, Help, Quit };
+    enum { Empty, Install, Debug, Run, RunFile, RunTemp, Browse, Delete,
+           Edit, Terminate, Suspend, Resume, Output, Warm, Settings, About, Help, Quit };
 
     explicit MainMenu(bool autoclose, const QStringList &runList, const QStringList &busyList, QWidget *parent = nullptr);
 
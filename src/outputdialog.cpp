@@ -24,14 +24,20 @@
 #include <QUrl>
 
 #include "ui_outputdialog.h"
+#include "singletonwidget.h"
 #include "outputdialog.h"
 #include "filesystem.h"
 #include "netdialog.h"
 #include "dialogs.h"
 
-OutputDialog::OutputDialog(const Ex::Out &out, QWidget *parent) :
-    SingletonDialog(parent),
-    ui(new Ui::OutputDialog)
+const int FLUSH_INTERVAL = 16;
+const int MAX_BLOCKS = 5000;
+
+OutputDialog::OutputDialog(const Ex::Log &log, const Ex::Analyzer &analyzer, QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::OutputDialog),
+    mLog(log),
+    mAnalyzer(analyzer)
 {
     ui->setupUi(this);
     QSettings s("winewizard", "settings");
@@ -40,27 +46,24 @@ OutputDialog::OutputDialog(const Ex::Out &out, QWidget *parent) :
     ui->vSplitter->restoreState(s.value("VSplitter").toByteArray());
     ui->hSplitter->restoreState(s.value("HSplitter").toByteArray());
     s.endGroup();
-    ui->out->appendPlainText(out.first);
-    ui->err->appendPlainText(out.second);
-
-    QSettings r(FS::cache().absoluteFilePath("main.wwrepo"), QSettings::IniFormat);
+    ui->out->setMaximumBlockCount(MAX_BLOCKS);
+    ui->err->setMaximumBlockCount(MAX_BLOCKS);
+    showTail(RunLog::Out);
+    showTail(RunLog::Err);
+    QPushButton *logBtn = ui->buttonBox->addButton(tr("Open Log"), QDialogButtonBox::ActionRole);
+    connect(logBtn, &QPushButton::clicked, this, [this]
     {
-        r.beginGroup("Errors");
-        for (const QString &package : r.childGroups())
-        {
-            r.beginGroup(package);
-            for (const QString &error : r.value("RE").toStringList())
-                if (out.second.contains(error))
-                {
-                    ui->advice->appendPlainText(tr("You can try to install package: %1.").arg(package));
-                    break;
-                }
-            r.endGroup();
-        }
-        r.endGroup();
-    }
-    if (ui->advice->toPlainText().isEmpty())
-        ui->advice->appendPlainText(tr("You can try to change the version of Wine."));
+        mLog->flush();
+        FS::browse(QFileInfo(mLog->path(RunLog::Err)).absolutePath());
+    });
+    for (QTextDecoder *&decoder : mDecoders)
+        decoder = QTextCodec::codecForLocale()->makeDecoder();
+    mTimer.setSingleShot(true);
+    mTimer.setInterval(FLUSH_INTERVAL);
+    connect(&mTimer, &QTimer::timeout, this, &OutputDialog::flush);
+    connect(mLog.data(), &RunLog::appended, this, &OutputDialog::appended);
+    connect(mAnalyzer.data(), &LogAnalyzer::changed, this, &OutputDialog::updateAdvice);
+    updateAdvice();
 }
 
 OutputDialog::~OutputDialog()
@@ -71,9 +74,51 @@ OutputDialog::~OutputDialog()
     s.setValue("VSplitter", ui->vSplitter->saveState());
     s.setValue("HSplitter", ui->hSplitter->saveState());
     s.endGroup();
+    for (QTextDecoder *decoder : mDecoders)
+        delete decoder;
     delete ui;
 }
 
+int OutputDialog::exec()
+{
+    SingletonWidget singleton(this);
+    return QDialog::exec();
+}
+
+void OutputDialog::showTail(RunLog::Channel channel)
+{
+    QPlainTextEdit *edit = channel == RunLog::Out ? ui->out : ui->err;
+    if (mLog->truncated(channel))
+        edit->appendPlainText(tr("*** Only the end of the output is shown, the full log is in %1 ***\n")
+                              .arg(mLog->path(channel)));
+    edit->appendPlainText(mLog->tail(channel));
+}
+
+void OutputDialog::appended(RunLog::Channel channel, const QByteArray &data)
+{
+    mPending[channel].append(data);
+    if (!mTimer.isActive())
+        mTimer.start();
+}
+
+void OutputDialog::flush()
+{
+    QPlainTextEdit *edits[] = { ui->out, ui->err };
+    for (int i = RunLog::Out; i <= RunLog::Err; ++i)
+        if (!mPending[i].isEmpty())
+        {
+            QTextCursor cursor(edits[i]->document());
+            cursor.movePosition(QTextCursor::End);
+            cursor.insertText(mDecoders[i]->toUnicode(mPending[i]));
+            mPending[i].clear();
+        }
+}
+
+void OutputDialog::updateAdvice()
+{
+    ui->advice->setPlainText(mAnalyzer->advice().join('\n'));
+}
+
 void OutputDialog::on_buttonBox_helpRequested()
 {
     QDesktopServices::openUrl(QUrl(HELP_URL));
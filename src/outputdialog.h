@@ -21,26 +21,42 @@
 #ifndef OUTPUTDIALOG_H
 #define OUTPUTDIALOG_H
 
-#include "singletondialog.h"
+#include <QDialog>
+#include <QTextCodec>
+#include <QTimer>
+
 #include "executor.h"
 
 namespace Ui {
 class OutputDialog;
 }
 
-class OutputDialog : public SingletonDialog
+class OutputDialog : public QDialog
 {
     Q_OBJECT
 
 public:
-    explicit OutputDialog(const Ex::Out &out, QWidget *parent = nullptr);
+    explicit OutputDialog(const Ex::Log &log, const Ex::Analyzer &analyzer, QWidget *parent = nullptr);
     ~OutputDialog() override;
 
+public slots:
+    int exec() override;
+
 private slots:
+    void flush();
     void on_buttonBox_helpRequested();
 
 private:
     Ui::OutputDialog *ui;
+    Ex::Log mLog;
+    Ex::Analyzer mAnalyzer;
+    QByteArray mPending[2];
+    QTextDecoder *mDecoders[2];
+    QTimer mTimer;
+
+    void showTail(RunLog::Channel channel);
+    void appended(RunLog::Channel channel, const QByteArray &data);
+    void updateAdvice();
 };
 
 #endif // OUTPUTDIALOG_H
@@ -0,0 +1,143 @@
+/***************************************************************************
+ *   Copyright (C) 2016 by Vitalii Kachemtsev <LLIAKAJL@yandex.ru>         *
+ *                                                                         *
+ *   This file is part of Wine Wizard.                                     *
+ *                                                                         *
+ *   Wine Wizard is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   Wine Wizard is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with Wine Wizard.  If not, see <http://www.gnu.org/licenses/>.  *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QThreadPool>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QRunnable>
+#include <QDir>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "filesystem.h"
+#include "prefetcher.h"
+#include "process.h"
+
+const int SAMPLE_INTERVAL = 1000;
+const int SAMPLE_COUNT = 30;
+const int PROFILE_MAX_AGE = 7;
+
+class ReadaheadTask : public QRunnable
+{
+public:
+    explicit ReadaheadTask(const QStringList &files) :
+        mFiles(files)
+    {
+    }
+
+    void run() override
+    {
+        for (const QString &file : mFiles)
+        {
+            int fd = open(QFile::encodeName(file).constData(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0)
+                continue;
+            posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+            close(fd);
+        }
+    }
+
+private:
+    QStringList mFiles;
+};
+
+Prefetcher::Prefetcher(Ex::Job *job, const QString &profile) :
+    QObject(job),
+    mProfile(profile),
+    mPrefixPath(FS::prefix(job->prefixHash()).absolutePath()),
+    mRoot(FS::data().canonicalPath()),
+    mSamples(0)
+{
+    mTimer.setInterval(SAMPLE_INTERVAL);
+    connect(&mTimer, &QTimer::timeout, this, &Prefetcher::sample);
+    connect(job, &Ex::Job::finished, this, &Prefetcher::save);
+    mTimer.start();
+}
+
+QString Prefetcher::profile(const QString &shortcut)
+{
+    QFileInfo info(shortcut);
+    QDir dir(info.absoluteDir().absoluteFilePath(".prefetch"));
+    if (!dir.exists())
+        dir.mkpath(dir.absolutePath());
+    return dir.absoluteFilePath(info.fileName());
+}
+
+bool Prefetcher::stale(const QString &profile)
+{
+    QFileInfo info(profile);
+    return !info.exists() || info.lastModified().daysTo(QDateTime::currentDateTime()) > PROFILE_MAX_AGE;
+}
+
+void Prefetcher::prefetch(const QString &profile)
+{
+    QStringList files = FS::readFile(profile).split('\n', QString::SkipEmptyParts);
+    if (files.isEmpty())
+        return;
+    QThreadPool *pool = QThreadPool::globalInstance();
+    int chunk = qMax(1, files.count() / pool->maxThreadCount() + 1);
+    for (int i = 0; i < files.count(); i += chunk)
+        pool->start(new ReadaheadTask(files.mid(i, chunk)));
+}
+
+void Prefetcher::sample()
+{
+    for (qint64 pid : Proc::prefixProcesses(mPrefixPath))
+    {
+        QString proc = "/proc/" + QString::number(pid);
+        QFile maps(proc + "/maps");
+        if (maps.open(QFile::ReadOnly))
+            for (const QByteArray &line : maps.readAll().split('\n'))
+            {
+                int slash = line.indexOf('/');
+                if (slash > 0)
+                    add(QFile::decodeName(line.mid(slash)));
+            }
+        QDir fdDir(proc + "/fd");
+        for (const QFileInfo &fd : fdDir.entryInfoList(QDir::Files | QDir::System | QDir::NoDotAndDotDot))
+            add(fd.symLinkTarget());
+    }
+    if (++mSamples >= SAMPLE_COUNT)
+    {
+        mTimer.stop();
+        save();
+    }
+}
+
+void Prefetcher::add(const QString &path)
+{
+    if (path.isEmpty() || mSeen.contains(path))
+        return;
+    mSeen.insert(path);
+    if (path.startsWith(mRoot) && QFileInfo(path).isFile())
+        mFiles.append(path);
+}
+
+void Prefetcher::save()
+{
+    mTimer.stop();
+    if (mFiles.isEmpty())
+        return;
+    QFile f(mProfile);
+    if (f.open(QFile::WriteOnly | QFile::Truncate))
+        f.write(QFile::encodeName(mFiles.join('\n')));
+    mFiles.clear();
+}
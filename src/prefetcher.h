@@ -0,0 +1,53 @@
+/***************************************************************************
+ *   Copyright (C) 2016 by Vitalii Kachemtsev <LLIAKAJL@yandex.ru>         *
+ *                                                                         *
+ *   This file is part of Wine Wizard.                                     *
+ *                                                                         *
+ *   Wine Wizard is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   Wine Wizard is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with Wine Wizard.  If not, see <http://www.gnu.org/licenses/>.  *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef PREFETCHER_H
+#define PREFETCHER_H
+
+#include <QStringList>
+#include <QTimer>
+#include <QSet>
+
+#include "executor.h"
+
+class Prefetcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit Prefetcher(Ex::Job *job, const QString &profile);
+
+    static QString profile(const QString &shortcut);
+    static bool stale(const QString &profile);
+    static void prefetch(const QString &profile);
+
+private:
+    QString mProfile, mPrefixPath, mRoot;
+    QStringList mFiles;
+    QSet<QString> mSeen;
+    QTimer mTimer;
+    int mSamples;
+
+    void sample();
+    void add(const QString &path);
+    void save();
+};
+
+#endif // PREFETCHER_H
@@ -0,0 +1,79 @@
+/***************************************************************************
+ *   Copyright (C) 2016 by Vitalii Kachemtsev <LLIAKAJL@yandex.ru>         *
+ *                                                                         *
+ *   This file is part of Wine Wizard.                                     *
+ *                                                                         *
+ *   Wine Wizard is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   Wine Wizard is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with Wine Wizard.  If not, see <http://www.gnu.org/licenses/>.  *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "ui_presetwidget.h"
+#include "presetwidget.h"
+#include "executor.h"
+
+PresetWidget::PresetWidget(QWidget *parent) :
+    QGroupBox(parent),
+    ui(new Ui::PresetWidget)
+{
+    ui->setupUi(this);
+    mBoxes << ui->esync << ui->fsync << ui->sharedMemory << ui->threadedGL << ui->quiet;
+    setInherit(false);
+    setPresets(QVariantMap());
+}
+
+PresetWidget::~PresetWidget()
+{
+    delete ui;
+}
+
+void PresetWidget::setInherit(bool inherit)
+{
+    QString tip = inherit ? tr("Partially checked: use the prefix setting") :
+                            tr("Partially checked: keep the system default");
+    for (int i = 0; i < mBoxes.count(); ++i)
+    {
+        mBoxes.at(i)->setToolTip(tip);
+        mBoxes.at(i)->setHidden(inherit && Ex::SERVER_PRESETS.contains(Ex::PRESETS.at(i)));
+    }
+}
+
+void PresetWidget::setPresets(const QVariantMap &presets)
+{
+    for (int i = 0; i < mBoxes.count(); ++i)
+    {
+        const QString &key = Ex::PRESETS.at(i);
+        if (presets.contains(key))
+            mBoxes.at(i)->setCheckState(presets.value(key).toBool() ? Qt::Checked : Qt::Unchecked);
+        else
+            mBoxes.at(i)->setCheckState(Qt::PartiallyChecked);
+    }
+    ui->env->setPlainText(presets.value("Environment").toStringList().join('\n'));
+}
+
+QVariantMap PresetWidget::presets() const
+{
+    QVariantMap res;
+    for (int i = 0; i < mBoxes.count(); ++i)
+    {
+        Qt::CheckState state = mBoxes.at(i)->checkState();
+        if (state != Qt::PartiallyChecked && !mBoxes.at(i)->isHidden())
+            res.insert(Ex::PRESETS.at(i), state == Qt::Checked);
+    }
+    QStringList vars;
+    for (const QString &line : ui->env->toPlainText().split('\n', QString::SkipEmptyParts))
+        if (line.indexOf('=') > 0)
+            vars.append(line.trimmed());
+    res.insert("Environment", vars);
+    return res;
+}
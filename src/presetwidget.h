@@ -0,0 +1,49 @@
+/***************************************************************************
+ *   Copyright (C) 2016 by Vitalii Kachemtsev <LLIAKAJL@yandex.ru>         *
+ *                                                                         *
+ *   This file is part of Wine Wizard.                                     *
+ *                                                                         *
+ *   Wine Wizard is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   Wine Wizard is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with Wine Wizard.  If not, see <http://www.gnu.org/licenses/>.  *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef PRESETWIDGET_H
+#define PRESETWIDGET_H
+
+#include <QGroupBox>
+#include <QVariantMap>
+
+class QCheckBox;
+
+namespace Ui {
+class PresetWidget;
+}
+
+class PresetWidget : public QGroupBox
+{
+    Q_OBJECT
+
+public:
+    explicit PresetWidget(QWidget *parent = nullptr);
+    ~PresetWidget() override;
+    void setInherit(bool inherit);
+    void setPresets(const QVariantMap &presets);
+    QVariantMap presets() const;
+
+private:
+    Ui::PresetWidget *ui;
+    QList<QCheckBox *> mBoxes;
+};
+
+#endif // PRESETWIDGET_H
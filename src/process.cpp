@@ -0,0 +1,132 @@
+/***************************************************************************
+ *   Copyright (C) 2016 by Vitalii Kachemtsev <LLIAKAJL@yandex.ru>         *
+ *                                                                         *
+ *   This file is part of Wine Wizard.                                     *
+ *                                                                         *
+ *   Wine Wizard is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   Wine Wizard is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with Wine Wizard.  If not, see <http://www.gnu.org/licenses/>.  *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QDir>
+#include <QSet>
+
+#include <signal.h>
+
+#include "process.h"
+
+const QStringList SYSTEM_PROCESSES = QStringList() << "wineserver" << "services.exe" << "winedevice.exe"
+                                                   << "plugplay.exe" << "svchost.exe" << "rpcss.exe"
+                                                   << "explorer.exe" << "conhost.exe";
+const int SUSPEND_PASSES = 3;
+const int COMM_LENGTH = 15;
+
+namespace Proc
+{
+    PidList prefixProcesses(const QString &prefixPath)
+    {
+        PidList res;
+        QByteArray var = "WINEPREFIX=" + QDir(prefixPath).absolutePath().toLocal8Bit();
+        for (const QString &entry : QDir("/proc").entryList(QDir::Dirs | QDir::NoDotAndDotDot))
+        {
+            bool ok;
+            qint64 pid = entry.toLongLong(&ok);
+            if (!ok)
+                continue;
+            QFile f("/proc/" + entry + "/environ");
+            if (!f.open(QFile::ReadOnly))
+                continue;
+            for (const QByteArray &item : f.readAll().split('\0'))
+                if (item == var || item == var + '/')
+                {
+                    res.append(pid);
+                    break;
+                }
+        }
+        return res;
+    }
+
+    QString name(qint64 pid)
+    {
+        QFile f("/proc/" + QString::number(pid) + "/comm");
+        if (!f.open(QFile::ReadOnly))
+            return QString();
+        return QString::fromLocal8Bit(f.readAll()).trimmed();
+    }
+
+    bool system(qint64 pid)
+    {
+        QString n = name(pid);
+        if (n.isEmpty())
+            return false;
+        for (const QString &s : SYSTEM_PROCESSES)
+            if (n.compare(s.left(COMM_LENGTH), Qt::CaseInsensitive) == 0)
+                return true;
+        return false;
+    }
+
+    bool idle(const QString &prefixPath)
+    {
+        for (qint64 pid : prefixProcesses(prefixPath))
+            if (!system(pid))
+                return false;
+        return true;
+    }
+
+    static char state(qint64 pid)
+    {
+        QFile f("/proc/" + QString::number(pid) + "/stat");
+        if (!f.open(QFile::ReadOnly))
+            return 0;
+        QByteArray stat = f.readAll();
+        int pos = stat.lastIndexOf(')') + 2;
+        return pos > 1 && pos < stat.size() ? stat.at(pos) : 0;
+    }
+
+    bool suspended(const QString &prefixPath)
+    {
+        for (qint64 pid : prefixProcesses(prefixPath))
+            if (state(pid) == 'T')
+                return true;
+        return false;
+    }
+
+    void suspend(const QString &prefixPath)
+    {
+        QSet<qint64> stopped;
+        for (int i = 0; i < SUSPEND_PASSES; ++i)
+        {
+            bool found = false;
+            for (qint64 pid : prefixProcesses(prefixPath))
+                if (!stopped.contains(pid))
+                {
+                    ::kill(pid, SIGSTOP);
+                    stopped.insert(pid);
+                    found = true;
+                }
+            if (!found)
+                break;
+        }
+    }
+
+    void resume(const QString &prefixPath)
+    {
+        send(prefixPath, SIGCONT);
+    }
+
+    void send(const QString &prefixPath, int sig)
+    {
+        for (qint64 pid : prefixProcesses(prefixPath))
+            ::kill(pid, sig);
+    }
+}
@@ -0,0 +1,40 @@
+/***************************************************************************
+ *   Copyright (C) 2016 by Vitalii Kachemtsev <LLIAKAJL@yandex.ru>         *
+ *                                                                         *
+ *   This file is part of Wine Wizard.                                     *
+ *                                                                         *
+ *   Wine Wizard is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   Wine Wizard is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with Wine Wizard.  If not, see <http://www.gnu.org/licenses/>.  *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef PROCESS_H
+#define PROCESS_H
+
+#include <QStringList>
+
+namespace Proc
+{
+    typedef QList<qint64> PidList;
+
+    PidList prefixProcesses(const QString &prefixPath);
+    QString name(qint64 pid);
+    bool system(qint64 pid);
+    bool idle(const QString &prefixPath);
+    bool suspended(const QString &prefixPath);
+    void suspend(const QString &prefixPath);
+    void resume(const QString &prefixPath);
+    void send(const QString &prefixPath, int sig);
+}
+
+#endif // PROCESS_H
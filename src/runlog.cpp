@@ -0,0 +1,111 @@
+/***************************************************************************
+ *   Copyright (C) 2016 by Vitalii Kachemtsev <LLIAKAJL@yandex.ru>         *
+ *                                                                         *
+ *   This file is part of Wine Wizard.                                     *
+ *                                                                         *
+ *   Wine Wizard is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   Wine Wizard is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with Wine Wizard.  If not, see <http://www.gnu.org/licenses/>.  *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QDateTime>
+#include <QDir>
+
+#include "runlog.h"
+
+const int MAX_RUN_LOGS = 10;
+
+RunLog::RunLog(const QDir &dir, int capacity, QObject *parent) :
+    QObject(parent)
+{
+    QStringList old = dir.entryList(QStringList("*.out") << "*.err", QDir::Files, QDir::Name);
+    while (old.count() >= MAX_RUN_LOGS * 2)
+        dir.remove(old.takeFirst());
+    QString base = dir.absoluteFilePath(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmsszzz"));
+    const char *suffix[] = { ".out", ".err" };
+    for (int i = Out; i <= Err; ++i)
+    {
+        Ring &r = mRings[i];
+        r.data.resize(capacity);
+        r.pos = 0;
+        r.size = 0;
+        r.total = 0;
+        r.file.setFileName(base + suffix[i]);
+        r.file.open(QFile::WriteOnly | QFile::Truncate);
+    }
+}
+
+RunLog::~RunLog()
+{
+    flush();
+}
+
+void RunLog::append(Channel channel, const QByteArray &data)
+{
+    if (data.isEmpty())
+        return;
+    Ring &r = mRings[channel];
+    r.file.write(data);
+    r.total += data.size();
+    int cap = r.data.size();
+    const char *src = data.constData();
+    int len = data.size();
+    if (len > cap)
+    {
+        src += len - cap;
+        len = cap;
+    }
+    int first = qMin(len, cap - r.pos);
+    memcpy(r.data.data() + r.pos, src, first);
+    memcpy(r.data.data(), src + first, len - first);
+    r.pos = (r.pos + len) % cap;
+    r.size = qMin(cap, r.size + len);
+    emit appended(channel, data);
+}
+
+void RunLog::flush()
+{
+    for (Ring &r : mRings)
+        r.file.flush();
+}
+
+QString RunLog::tail(Channel channel) const
+{
+    const Ring &r = mRings[channel];
+    QByteArray res;
+    if (r.size < r.data.size())
+        res = r.data.left(r.size);
+    else
+    {
+        res = r.data.mid(r.pos) + r.data.left(r.pos);
+        int nl = res.indexOf('\n');
+        if (nl >= 0)
+            res.remove(0, nl + 1);
+    }
+    return QString::fromLocal8Bit(res);
+}
+
+QString RunLog::path(Channel channel) const
+{
+    return mRings[channel].file.fileName();
+}
+
+qint64 RunLog::size(Channel channel) const
+{
+    return mRings[channel].total;
+}
+
+bool RunLog::truncated(Channel channel) const
+{
+    return mRings[channel].total > mRings[channel].size;
+}
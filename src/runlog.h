@@ -0,0 +1,59 @@
+/***************************************************************************
+ *   Copyright (C) 2016 by Vitalii Kachemtsev <LLIAKAJL@yandex.ru>         *
+ *                                                                         *
+ *   This file is part of Wine Wizard.                                     *
+ *                                                                         *
+ *   Wine Wizard is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   Wine Wizard is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with Wine Wizard.  If not, see <http://www.gnu.org/licenses/>.  *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef RUNLOG_H
+#define RUNLOG_H
+
+#include <QFile>
+#include <QDir>
+
+class RunLog : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Channel { Out, Err };
+
+    explicit RunLog(const QDir &dir, int capacity = 256 * 1024, QObject *parent = nullptr);
+    ~RunLog() override;
+
+    void append(Channel channel, const QByteArray &data);
+    void flush();
+    QString tail(Channel channel) const;
+    QString path(Channel channel) const;
+    qint64 size(Channel channel) const;
+    bool truncated(Channel channel) const;
+
+signals:
+    void appended(RunLog::Channel channel, const QByteArray &data);
+
+private:
+    struct Ring
+    {
+        QByteArray data;
+        int pos, size;
+        qint64 total;
+        QFile file;
+    };
+
+    Ring mRings[2];
+};
+
+#endif // RUNLOG_H
@@ -53,6 +53,12 @@ SettingsDialog::SettingsDialog(QWidget *parent) :
     ui->height->setValue(sh);
     ui->vm->setValue(vm);
     ui->useScripts->setChecked(s.value("UseScripts", false).toBool());
+    ui->directLaunch->setChecked(s.value("DirectLaunch", true).toBool());
+    ui->shaderBudget->setValue(s.value("ShaderCache/Budget", 4096).toInt());
+    s.beginGroup("Warm");
+    ui->warm->setChecked(s.value("Enabled", false).toBool());
+    ui->warmTimeout->setValue(s.value("Timeout", 10).toInt());
+    s.endGroup();
 }
 
 SettingsDialog::~SettingsDialog()
@@ -81,6 +87,12 @@ void SettingsDialog::accept()
     s.setValue("Autoclose", ui->quit->isChecked());
     s.endGroup();
     s.setValue("UseScripts", ui->useScripts->isChecked());
+    s.setValue("DirectLaunch", ui->directLaunch->isChecked());
+    s.setValue("ShaderCache/Budget", ui->shaderBudget->value());
+    s.beginGroup("Warm");
+    s.setValue("Enabled", ui->warm->isChecked());
+    s.setValue("Timeout", ui->warmTimeout->value());
+    s.endGroup();
     QDialog::accept();
 }
 
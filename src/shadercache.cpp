@@ -0,0 +1,174 @@
+/***************************************************************************
+ *   Copyright (C) 2016 by Vitalii Kachemtsev <LLIAKAJL@yandex.ru>         *
+ *                                                                         *
+ *   This file is part of Wine Wizard.                                     *
+ *                                                                         *
+ *   Wine Wizard is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   Wine Wizard is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with Wine Wizard.  If not, see <http://www.gnu.org/licenses/>.  *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QCryptographicHash>
+#include <QDirIterator>
+#include <QThreadPool>
+#include <QDateTime>
+#include <QRunnable>
+#include <QSettings>
+#include <QMutex>
+#include <QMap>
+#include <QHash>
+#include <QFile>
+
+#include "shadercache.h"
+#include "filesystem.h"
+
+const qint64 KEY_SAMPLE = 1024 * 1024;
+const int DEFAULT_BUDGET = 4096;
+const QString STAMP = ".used";
+const QStringList SUBDIRS = QStringList() << "nvidia" << "mesa" << "dxvk" << "vkd3d";
+
+namespace Shaders
+{
+    static QMutex gPruneLock;
+    static QMutex gKeyLock;
+    static QHash<QString, QString> gKeys;
+
+    static qint64 dirSize(const QString &path)
+    {
+        qint64 res = 0;
+        QDirIterator it(path, QDir::Files | QDir::Hidden | QDir::NoSymLinks, QDirIterator::Subdirectories);
+        while (it.hasNext())
+        {
+            it.next();
+            res += it.fileInfo().size();
+        }
+        return res;
+    }
+
+    class PruneTask : public QRunnable
+    {
+    public:
+        PruneTask(const QString &keep, const QDateTime &since, qint64 budget) :
+            mKeep(keep),
+            mSince(since),
+            mBudget(budget)
+        {
+        }
+
+        void run() override
+        {
+            if (!gPruneLock.tryLock())
+                return;
+            QDir root = FS::shaders();
+            QMultiMap<QDateTime, QString> used;
+            QHash<QString, qint64> sizes;
+            qint64 total = 0;
+            for (const QString &key : root.entryList(QDir::Dirs | QDir::NoDotAndDotDot))
+            {
+                QString path = root.absoluteFilePath(key);
+                qint64 size = dirSize(path);
+                sizes.insert(key, size);
+                total += size;
+                used.insert(QFileInfo(path + '/' + STAMP).lastModified(), key);
+            }
+            for (auto it = used.cbegin(); it != used.cend() && total > mBudget; ++it)
+                if (it.value() != mKeep && !(mSince.isValid() && it.key() >= mSince) &&
+                    QDir(root.absoluteFilePath(it.value())).removeRecursively())
+                    total -= sizes.value(it.value());
+            gPruneLock.unlock();
+        }
+
+    private:
+        QString mKeep;
+        QDateTime mSince;
+        qint64 mBudget;
+    };
+
+    QString key(const QString &exe)
+    {
+        QFileInfo info(exe);
+        QString id = info.canonicalFilePath() + '|' + QString::number(info.lastModified().toMSecsSinceEpoch());
+        {
+            QMutexLocker locker(&gKeyLock);
+            QHash<QString, QString>::const_iterator it = gKeys.constFind(id);
+            if (it != gKeys.constEnd())
+                return it.value();
+        }
+        QFile f(exe);
+        if (!f.open(QFile::ReadOnly))
+            return QString();
+        QCryptographicHash hash(QCryptographicHash::Sha1);
+        hash.addData(QByteArray::number(f.size()));
+        hash.addData(f.read(KEY_SAMPLE));
+        if (f.size() > KEY_SAMPLE * 2)
+            f.seek(f.size() - KEY_SAMPLE);
+        hash.addData(f.read(KEY_SAMPLE));
+        QString res = hash.result().toHex();
+        QMutexLocker locker(&gKeyLock);
+        gKeys.insert(id, res);
+        return res;
+    }
+
+    QString stamp(const QString &exe)
+    {
+        QString k = key(exe);
+        return k.isEmpty() ? QString() : FS::shaders().absoluteFilePath(k + '/' + STAMP);
+    }
+
+    QStringList dirs(const QString &exe)
+    {
+        QStringList res;
+        QString k = key(exe);
+        if (!k.isEmpty())
+            for (const QString &sub : SUBDIRS)
+                res.append(FS::shaders().absoluteFilePath(k + '/' + sub));
+        return res;
+    }
+
+    QProcessEnvironment env(const QString &exe)
+    {
+        QProcessEnvironment res;
+        QString k = key(exe);
+        if (k.isEmpty())
+            return res;
+        QDir dir = FS::shaders().absoluteFilePath(k);
+        for (const QString &sub : SUBDIRS)
+            dir.mkpath(sub);
+        res.insert("__GL_SHADER_DISK_CACHE", "1");
+        res.insert("__GL_SHADER_DISK_CACHE_PATH", dir.absoluteFilePath("nvidia"));
+        res.insert("__GL_SHADER_DISK_CACHE_SKIP_CLEANUP", "1");
+        res.insert("MESA_SHADER_CACHE_DIR", dir.absoluteFilePath("mesa"));
+        res.insert("MESA_GLSL_CACHE_DIR", dir.absoluteFilePath("mesa"));
+        res.insert("DXVK_STATE_CACHE_PATH", dir.absoluteFilePath("dxvk"));
+        res.insert("VKD3D_SHADER_CACHE_PATH", dir.absoluteFilePath("vkd3d"));
+        return res;
+    }
+
+    void touch(const QString &exe, const QDateTime &since)
+    {
+        QString k = key(exe);
+        if (k.isEmpty())
+            return;
+        QFile f(FS::shaders().absoluteFilePath(k + '/' + STAMP));
+        if (f.open(QFile::WriteOnly | QFile::Truncate))
+            f.write(QByteArray::number(QDateTime::currentMSecsSinceEpoch()));
+        f.close();
+        prune(k, since);
+    }
+
+    void prune(const QString &keep, const QDateTime &since)
+    {
+        qint64 budget = QSettings("winewizard", "settings").value("ShaderCache/Budget", DEFAULT_BUDGET).toLongLong();
+        QThreadPool::globalInstance()->start(new PruneTask(keep, since, budget * 1024 * 1024));
+    }
+}
@@ -0,0 +1,170 @@
+/***************************************************************************
+ *   Copyright (C) 2016 by Vitalii Kachemtsev <LLIAKAJL@yandex.ru>         *
+ *                                                                         *
+ *   This file is part of Wine Wizard.                                     *
+ *                                                                         *
+ *   Wine Wizard is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   Wine Wizard is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with Wine Wizard.  If not, see <http://www.gnu.org/licenses/>.  *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QSettings>
+#include <QProcess>
+#include <QUuid>
+
+#include "filesystem.h"
+#include "templates.h"
+
+const int DEFAULT_POOL_SIZE = 1;
+const QStringList PRIVATE = { ".wine", ".settings", ".logs", ".journal" };
+
+namespace Templates
+{
+    static bool gRefilling = false;
+
+    static QDir root()
+    {
+        QDir res = FS::data().absoluteFilePath(".templates");
+        if (!res.exists())
+            res.mkpath(res.absolutePath());
+        return res;
+    }
+
+    static QDir pool(const QString &key)
+    {
+        QDir res = root().absoluteFilePath(".pool/" + key);
+        if (!res.exists())
+            res.mkpath(res.absolutePath());
+        return res;
+    }
+
+    QString path(const QString &wine, const QString &arch)
+    {
+        return root().absoluteFilePath(wine + '-' + arch);
+    }
+
+    bool exists(const QString &wine, const QString &arch)
+    {
+        return QFileInfo(path(wine, arch)).isDir();
+    }
+
+    bool vacant(const QDir &prefix)
+    {
+        for (const QString &entry : prefix.entryList(QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden | QDir::System))
+            if (!PRIVATE.contains(entry))
+                return false;
+        return true;
+    }
+
+    void clear(const QDir &prefix)
+    {
+        for (const QFileInfo &info : prefix.entryInfoList(QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden | QDir::System))
+            if (!PRIVATE.contains(info.fileName()))
+            {
+                if (info.isDir() && !info.isSymLink())
+                    QDir(info.absoluteFilePath()).removeRecursively();
+                else
+                    QFile::remove(info.absoluteFilePath());
+            }
+    }
+
+    bool take(const QString &wine, const QString &arch, const QDir &prefix)
+    {
+        if (!vacant(prefix))
+            return false;
+        QDir p = pool(wine + '-' + arch);
+        for (const QString &clone : p.entryList(QDir::Dirs | QDir::NoDotAndDotDot))
+        {
+            QDir src = p.absoluteFilePath(clone);
+            QStringList entries = src.entryList(QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden | QDir::System);
+            QStringList moved;
+            bool ok = true;
+            for (const QString &entry : entries)
+                if (ok && !PRIVATE.contains(entry))
+                {
+                    ok = src.rename(entry, prefix.absoluteFilePath(entry));
+                    if (ok)
+                        moved.append(entry);
+                }
+            if (!ok)
+                for (const QString &entry : moved)
+                    QDir().rename(prefix.absoluteFilePath(entry), src.absoluteFilePath(entry));
+            src.removeRecursively();
+            if (ok)
+                return true;
+        }
+        return false;
+    }
+
+    bool prune()
+    {
+        bool res = false;
+        QDir r = root();
+        QDir store = FS::wines();
+        for (const QString &key : r.entryList(QDir::Dirs | QDir::NoDotAndDotDot))
+            if (!key.endsWith(".part") && !store.exists(key))
+            {
+                FS::discard(r.absoluteFilePath(key));
+                res = true;
+            }
+        QDir p = r.absoluteFilePath(".pool");
+        for (const QString &key : p.entryList(QDir::Dirs | QDir::NoDotAndDotDot))
+            if (!store.exists(key))
+            {
+                FS::discard(p.absoluteFilePath(key));
+                res = true;
+            }
+        return res;
+    }
+
+    void refill()
+    {
+        if (gRefilling)
+            return;
+        int size = QSettings("winewizard", "settings").value("Templates/Pool", DEFAULT_POOL_SIZE).toInt();
+        QDir r = root();
+        for (const QString &key : r.entryList(QDir::Dirs | QDir::NoDotAndDotDot))
+        {
+            if (key.endsWith(".part"))
+                continue;
+            QDir p = pool(key);
+            for (const QString &part : p.entryList(QStringList(".*.part"), QDir::Dirs | QDir::Hidden))
+                QDir(p.absoluteFilePath(part)).removeRecursively();
+            if (p.entryList(QDir::Dirs | QDir::NoDotAndDotDot).count() >= size)
+                continue;
+            QString name = QUuid::createUuid().toString().mid(1, 8);
+            QString part = p.absoluteFilePath('.' + name + ".part");
+            QProcess *proc = new QProcess;
+            QObject::connect(proc, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished),
+                             proc, [proc, p, name, part](int code, QProcess::ExitStatus status)
+            {
+                gRefilling = false;
+                if (status == QProcess::NormalExit && code == 0)
+                    QDir().rename(part, p.absoluteFilePath(name));
+                proc->deleteLater();
+                refill();
+            });
+            QObject::connect(proc, static_cast<void (QProcess::*)(QProcess::ProcessError)>(&QProcess::error), proc, [proc](QProcess::ProcessError err)
+            {
+                if (err == QProcess::FailedToStart)
+                {
+                    gRefilling = false;
+                    proc->deleteLater();
+                }
+            });
+            gRefilling = true;
+            proc->start("cp", QStringList() << "-a" << "--reflink=auto" << r.absoluteFilePath(key) << part);
+            return;
+        }
+    }
+}
@@ -25,11 +25,17 @@
 
 #include "ui_terminaldialog.h"
 #include "terminaldialog.h"
+#include "filesystem.h"
 #include "netdialog.h"
+#include "dialogs.h"
 
-TerminalDialog::TerminalDialog(QWidget *parent) :
+const int FLUSH_INTERVAL = 16;
+const int MAX_BLOCKS = 5000;
+
+TerminalDialog::TerminalDialog(const Ex::Log &log, QWidget *parent) :
     SingletonDialog(parent),
-    ui(new Ui::TerminalDialog)
+    ui(new Ui::TerminalDialog),
+    mLog(log)
 {
     ui->setupUi(this);
     QSettings s("winewizard", "settings");
@@ -39,6 +45,20 @@ TerminalDialog::TerminalDialog(QWidget *parent) :
     ui->close->setChecked(s.value("Close", false).toBool());
     s.endGroup();
     ui->buttonBox->button(QDialogButtonBox::Close)->setEnabled(false);
+    ui->out->setMaximumBlockCount(MAX_BLOCKS);
+    ui->err->setMaximumBlockCount(MAX_BLOCKS);
+    QPushButton *logBtn = ui->buttonBox->addButton(tr("Open Log"), QDialogButtonBox::ActionRole);
+    connect(logBtn, &QPushButton::clicked, this, [this]
+    {
+        mLog->flush();
+        FS::browse(QFileInfo(mLog->path(RunLog::Out)).absolutePath());
+    });
+    for (QTextDecoder *&decoder : mDecoders)
+        decoder = QTextCodec::codecForLocale()->makeDecoder();
+    mTimer.setSingleShot(true);
+    mTimer.setInterval(FLUSH_INTERVAL);
+    connect(&mTimer, &QTimer::timeout, this, &TerminalDialog::flush);
+    connect(mLog.data(), &RunLog::appended, this, &TerminalDialog::append);
 }
 
 TerminalDialog::~TerminalDialog()
@@ -49,34 +69,44 @@ TerminalDialog::~TerminalDialog()
     s.setValue("Splitter", ui->splitter->saveState());
     s.setValue("Close", ui->close->isChecked());
     s.endGroup();
+    for (QTextDecoder *decoder : mDecoders)
+        delete decoder;
     delete ui;
 }
 
-void TerminalDialog::appendOut(const QString &text)
+void TerminalDialog::append(RunLog::Channel channel, const QByteArray &data)
 {
-    QTextCursor prev = ui->out->textCursor();
-    ui->out->moveCursor(QTextCursor::End);
-    ui->out->insertPlainText(text);
-    ui->out->setTextCursor(prev);
+    mPending[channel].append(data);
+    if (!mTimer.isActive())
+        mTimer.start();
 }
 
-void TerminalDialog::appendErr(const QString &text)
+void TerminalDialog::flush()
 {
-    QTextCursor prev = ui->err->textCursor();
-    ui->err->moveCursor(QTextCursor::End);
-    ui->err->insertPlainText(text);
-    ui->err->setTextCursor(prev);
+    QPlainTextEdit *edits[] = { ui->out, ui->err };
+    for (int i = RunLog::Out; i <= RunLog::Err; ++i)
+        if (!mPending[i].isEmpty())
+        {
+            QTextCursor cursor(edits[i]->document());
+            cursor.movePosition(QTextCursor::End);
+            cursor.insertText(mDecoders[i]->toUnicode(mPending[i]));
+            mPending[i].clear();
+        }
 }
 
 void TerminalDialog::reject()
 {
     if (ui->buttonBox->button(QDialogButtonBox::Close)->isEnabled())
         QDialog::reject();
+    else if (Dialogs::confirm(tr("Are you sure you want to stop the running script?"), this))
+        emit stopRequested();
 }
 
 void TerminalDialog::executeFinished()
 {
-    bool empty = ui->out->toPlainText().isEmpty() && ui->err->toPlainText().isEmpty();
+    mTimer.stop();
+    flush();
+    bool empty = ui->out->document()->isEmpty() && ui->err->document()->isEmpty();
     if (ui->close->isChecked() || empty)
         QDialog::accept();
     ui->buttonBox->button(QDialogButtonBox::Close)->setEnabled(true);
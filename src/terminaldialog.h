@@ -21,7 +21,11 @@
 #ifndef TERMINALDIALOG_H
 #define TERMINALDIALOG_H
 
+#include <QTextCodec>
+#include <QTimer>
+
 #include "singletondialog.h"
+#include "executor.h"
 
 namespace Ui {
 class TerminalDialog;
@@ -32,20 +36,27 @@ class TerminalDialog : public SingletonDialog
     Q_OBJECT
 
 public:
-    explicit TerminalDialog(QWidget *parent = nullptr);
+    explicit TerminalDialog(const Ex::Log &log, QWidget *parent = nullptr);
     ~TerminalDialog() override;
 
+signals:
+    void stopRequested();
+
 public slots:
-    void appendOut(const QString &text);
-    void appendErr(const QString &text);
+    void append(RunLog::Channel channel, const QByteArray &data);
     void reject() override;
     void executeFinished();
 
 private slots:
+    void flush();
     void on_buttonBox_helpRequested();
 
 private:
     Ui::TerminalDialog *ui;
+    Ex::Log mLog;
+    QByteArray mPending[2];
+    QTextDecoder *mDecoders[2];
+    QTimer mTimer;
 };
 
 #endif // TERMINALDIALOG_H
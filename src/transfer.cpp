@@ -0,0 +1,130 @@
+/***************************************************************************
+ *   Copyright (C) 2016 by Vitalii Kachemtsev <LLIAKAJL@yandex.ru>         *
+ *                                                                         *
+ *   This file is part of Wine Wizard.                                     *
+ *                                                                         *
+ *   Wine Wizard is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   Wine Wizard is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with Wine Wizard.  If not, see <http://www.gnu.org/licenses/>.  *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QNetworkRequest>
+#include <QNetworkReply>
+#include <QRegExp>
+
+#include "filesystem.h"
+#include "transfer.h"
+
+Transfer::Transfer(QNetworkAccessManager *nam, const QStringList &mirrors, const QString &outFile,
+                   const QString &checkSum, const QStringList &reList, QObject *parent) :
+    QObject(parent),
+    mNam(nam),
+    mMirrors(mirrors),
+    mReList(reList),
+    mCheckSum(checkSum),
+    mOut(outFile),
+    mHash(QCryptographicHash::Sha1)
+{
+    while (mReList.count() < mMirrors.count())
+        mReList.append(QString());
+}
+
+int Transfer::mirrors() const
+{
+    return mMirrors.count();
+}
+
+void Transfer::start()
+{
+    abort();
+    if (mMirrors.isEmpty())
+    {
+        emit failed(tr("No mirrors for file!"));
+        return;
+    }
+    emit urlChanged(mMirrors.first());
+    mHash.reset();
+    mOut.open(QFile::WriteOnly | QFile::Truncate);
+    QNetworkRequest request(mMirrors.first());
+    QSslConfiguration conf = request.sslConfiguration();
+    conf.setPeerVerifyMode(QSslSocket::VerifyNone);
+    request.setSslConfiguration(conf);
+    request.setRawHeader("User-Agent", "Mozilla Firefox");
+    mReply = mNam->get(request);
+    connect(mReply, &QNetworkReply::downloadProgress, this, &Transfer::progress);
+    connect(mReply, &QNetworkReply::readyRead, this, &Transfer::readyRead);
+    connect(mReply, &QNetworkReply::finished, this, &Transfer::downloadFinished);
+}
+
+void Transfer::retry()
+{
+    if (!mMirrors.isEmpty())
+    {
+        mMirrors.append(mMirrors.takeFirst());
+        mReList.append(mReList.takeFirst());
+    }
+    start();
+}
+
+void Transfer::abort()
+{
+    if (mReply)
+    {
+        mReply->disconnect(this);
+        mReply->abort();
+        mReply->deleteLater();
+    }
+    mOut.close();
+}
+
+void Transfer::readyRead()
+{
+    if (mReply->error() == QNetworkReply::NoError)
+    {
+        QByteArray data = mReply->readAll();
+        mOut.write(data);
+        mHash.addData(data);
+    }
+}
+
+void Transfer::downloadFinished()
+{
+    QNetworkReply *reply = mReply;
+    mReply = nullptr;
+    reply->deleteLater();
+    mOut.close();
+    if (reply->error() != QNetworkReply::NoError)
+    {
+        emit failed(tr("Network error: %1").arg(reply->errorString()));
+        return;
+    }
+    QString redirect = reply->attribute(QNetworkRequest::RedirectionTargetAttribute).toString();
+    if (!redirect.isEmpty())
+    {
+        mMirrors.first() = redirect;
+        start();
+    }
+    else if (!mReList.first().isEmpty())
+    {
+        QRegExp re(mReList.first());
+        re.setMinimal(true);
+        re.indexIn(FS::readFile(mOut.fileName()));
+        mMirrors.first() = re.cap(1);
+        mReList.first().clear();
+        start();
+    }
+    else if (!mCheckSum.isEmpty() && QString(mHash.result().toHex()) != mCheckSum)
+        emit failed(tr("Invalid checksum for file!"));
+    else
+        emit succeeded();
+}
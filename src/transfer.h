@@ -0,0 +1,63 @@
+/***************************************************************************
+ *   Copyright (C) 2016 by Vitalii Kachemtsev <LLIAKAJL@yandex.ru>         *
+ *                                                                         *
+ *   This file is part of Wine Wizard.                                     *
+ *                                                                         *
+ *   Wine Wizard is free software: you can redistribute it and/or modify   *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation, either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   Wine Wizard is distributed in the hope that it will be useful,        *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with Wine Wizard.  If not, see <http://www.gnu.org/licenses/>.  *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TRANSFER_H
+#define TRANSFER_H
+
+#include <QNetworkAccessManager>
+#include <QCryptographicHash>
+#include <QPointer>
+#include <QFile>
+
+class QNetworkReply;
+
+class Transfer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit Transfer(QNetworkAccessManager *nam, const QStringList &mirrors, const QString &outFile,
+                      const QString &checkSum = QString(), const QStringList &reList = QStringList(),
+                      QObject *parent = nullptr);
+
+    int mirrors() const;
+    void start();
+    void retry();
+    void abort();
+
+signals:
+    void urlChanged(const QString &url);
+    void progress(qint64 received, qint64 total);
+    void succeeded();
+    void failed(const QString &error);
+
+private:
+    QNetworkAccessManager *mNam;
+    QPointer<QNetworkReply> mReply;
+    QStringList mMirrors, mReList;
+    QString mCheckSum;
+    QFile mOut;
+    QCryptographicHash mHash;
+
+    void readyRead();
+    void downloadFinished();
+};
+
+#endif // TRANSFER_H
@@ -33,6 +33,12 @@ WaitDialog::~WaitDialog()
     delete ui;
 }
 
+void WaitDialog::setProgress(int value, int maximum)
+{
+    ui->progressBar->setRange(0, maximum);
+    ui->progressBar->setValue(value);
+}
+
 void WaitDialog::reject()
 {
 }
@@ -34,6 +34,7 @@ class WaitDialog : public SingletonDialog
 public:
     explicit WaitDialog(QWidget *parent = nullptr);
     ~WaitDialog() override;
+    void setProgress(int value, int maximum);
 
 public slots:
     void reject() override;
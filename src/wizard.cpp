@@ -19,9 +19,11 @@
  ***************************************************************************/
 
 #include <QDesktopServices>
+#include <QDateTime>
 #include <QSystemTrayIcon>
 #include <QApplication>
 #include <QStyle>
+#include <QTimer>
 #include <QMenu>
 #include <QUrl>
 
@@ -35,14 +37,28 @@
 #include "outputdialog.h"
 #include "scriptdialog.h"
 #include "aboutdialog.h"
+#include "templates.h"
+#include "fetcher.h"
+#include "installer.h"
+#include "ephemeral.h"
+#include "launcher.h"
+#include "prefetcher.h"
 #include "filesystem.h"
 #include "mainmenu.h"
+#include "process.h"
 #include "executor.h"
 #include "dialogs.h"
 #include "wizard.h"
 
-const QString PREPARE_PACKAGES = "ww_installed_%1()\n{\n%2\n}\nww_install_%1()\n{\n%3\n}\n";
+const QString PREPARE_PACKAGES = "ww_installed_%1()\n{\n%2\n}\nww_repo_install_%1()\n{\n%3\n}\nww_install_%1()\n{\nww_layer %1 %4\n}\n";
 const QString PREPARE_FUNCTIONS = "ww_%1()\n{\n%2\n}\n";
+const QString SCRIPT_STEP = "if ! ww_done script-%1\nthen\nww_info 'Start additional script ...'\n%2\n"
+                           "echo 'step script-%1' >> \"$WINEPREFIX/.journal\"\nfi\n";
+const QString LAYER_STATE = "test -n \"$WW_RESUME\" || WW_LAYER_STATE='1|%1|%2|%3|%4'\n";
+const int MAX_RECENT_WARM = 3;
+const int WARM_DELAY = 30000;
+const int LAYER_MAX_AGE = 30;
+const qint64 MIB = 1024 * 1024;
 const QString VERSION_ERR = QObject::tr("Please install a newer version of Wine Wizard.\n\nThe current version is %1.\n" \
                                         "The required version is %2.\n\nWine Wizard will exit.");
 
@@ -56,14 +72,26 @@ Wizard::Wizard(bool trayVisible, bool autoclose, QObject *parent) :
         f.open(QFile::ReadOnly);
         qApp->setStyleSheet(f.readAll());
     }
+    Ephemeral::cleanup();
+    reclaim();
     if (mTray)
     {
         mTray->setProperty("Autoclose", autoclose);
         connect(mTray, &QSystemTrayIcon::activated, this, [this]{ if (!SingletonWidget::exists()) showMenu(); });
         mTray->show();
+        if (!autoclose)
+        {
+            QTimer::singleShot(WARM_DELAY, this, &Wizard::warmUp);
+            QTimer::singleShot(WARM_DELAY, &Templates::refill);
+        }
     }
 }
 
+bool Wizard::idle() const
+{
+    return mBusyList.isEmpty() && Ex::jobs().isEmpty() && !FS::reclaiming();
+}
+
 void Wizard::start(const QString &cmdLine)
 {
     if (!SingletonWidget::exists())
@@ -82,10 +110,14 @@ void Wizard::start(const QString &cmdLine)
 
 void Wizard::showMenu()
 {
-    MainMenu menu(mTray ? mTray->property("Autoclose").toBool() : true, mRunList, mBusyList);
+    warmUp();
+    MainMenu menu(mTray ? mTray->property("Autoclose").toBool() : true, Ex::running(), mBusyList);
     QAction *act = menu.exec();
     if (!act)
+    {
+        checkIdle();
         return;
+    }
     switch (act->data().toInt())
     {
     case MainMenu::Install:
@@ -96,37 +128,10 @@ void Wizard::showMenu()
         }
         break;
     case MainMenu::Debug:
-        {
-            QString exe = act->property("Exe").toString();
-            QString args = act->property("Args").toString();
-            QString workDir = act->property("WorkDir").toString();
-            QString prefixHash = act->property("PrefixHash").toString();
-            QString shortcut = act->property("Shortcut").toString();
-            mRunList.append(prefixHash);
-            QString script = FS::readFile(":/run").arg(exe).arg(workDir).arg(args);
-            Ex::Out out = Ex::debug(script, prefixHash);
-            mRunList.removeOne(prefixHash);
-            if (qApp->property("Quit").toBool())
-                return;
-            if (Dialogs::finish(prefixHash))
-            {
-                QSettings s(shortcut, QSettings::IniFormat);
-                s.setValue("Debug", false);
-            }
-            else
-                OutputDialog(out).exec();
-        }
+        connect(launch(act, Ex::Job::Debug), &Ex::Job::finished, this, &Wizard::debugFinished);
         break;
     case MainMenu::Run:
-        {
-            QString exe = act->property("Exe").toString();
-            QString args = act->property("Args").toString();
-            QString workDir = act->property("WorkDir").toString();
-            QString prefixHash = act->property("PrefixHash").toString();
-            mRunList.append(prefixHash);
-            Ex::release(FS::readFile(":/run").arg(exe).arg(workDir).arg(args), prefixHash);
-            mRunList.removeOne(prefixHash);
-        }
+        connect(launch(act, Ex::Job::Release), &Ex::Job::finished, this, &Wizard::checkIdle);
         break;
     case MainMenu::RunFile:
         {
@@ -135,14 +140,21 @@ void Wizard::showMenu()
             QString exe = Dialogs::open(tr("Select Installer"), tr("Executable files (*.exe *.msi)"), nullptr, dir);
             if (!exe.isEmpty())
             {
-                mRunList.append(prefixHash);
-                QString script = FS::readFile(":/run").arg(exe).arg(QString()).arg(QString());
-                Ex::Out out = Ex::debug(script, prefixHash);
-                mRunList.removeOne(prefixHash);
-                if (qApp->property("Quit").toBool())
-                    return;
-                if (!Dialogs::finish(prefixHash))
-                    OutputDialog(out).exec();
+                QProcessEnvironment overlay = launchEnv(prefixHash, QVariantMap());
+                Ex::Job *job = Ex::launch(Ex::Job::Debug, exe, QString(), QString(), prefixHash, overlay);
+                keepWarm(job);
+                connect(job, &Ex::Job::finished, this, &Wizard::debugFinished);
+            }
+        }
+        break;
+    case MainMenu::RunTemp:
+        {
+            QString exe = Dialogs::open(tr("Select Installer"), tr("Executable files (*.exe *.msi)"));
+            if (!exe.isEmpty())
+            {
+                Ephemeral *ephemeral = new Ephemeral(act->property("PrefixHash").toString(), this);
+                connect(ephemeral, &Ephemeral::finished, this, &Wizard::ephemeralFinished);
+                ephemeral->start(exe);
             }
         }
         break;
@@ -154,7 +166,36 @@ void Wizard::showMenu()
             QString solutinName = act->property("PrefixName").toString();
             QString prefixHash = act->property("PrefixHash").toString();
             if (Dialogs::confirm(tr(R"(Are you sure you want to terminate "%1"?)").arg(solutinName)))
-                Ex::wait(FS::readFile(":/terminate"), prefixHash);
+            {
+                mWarm.remove(prefixHash);
+                Ex::terminate(QStringList(prefixHash), [this]{ checkIdle(); });
+            }
+        }
+        break;
+    case MainMenu::Suspend:
+        Proc::suspend(FS::prefix(act->property("PrefixHash").toString()).absolutePath());
+        break;
+    case MainMenu::Resume:
+        Proc::resume(FS::prefix(act->property("PrefixHash").toString()).absolutePath());
+        break;
+    case MainMenu::Output:
+        for (Ex::Job *job : Ex::jobs())
+            if (job->id() == act->property("JobId").toInt())
+            {
+                OutputDialog *od = new OutputDialog(job->log(), job->analyzer());
+                od->setAttribute(Qt::WA_DeleteOnClose);
+                od->show();
+                break;
+            }
+        break;
+    case MainMenu::Warm:
+        {
+            QString prefixHash = act->property("PrefixHash").toString();
+            QSettings s(FS::prefix(prefixHash).absoluteFilePath(".settings"), QSettings::IniFormat);
+            s.setIniCodec("UTF-8");
+            s.setValue("Warm", act->isChecked());
+            s.sync();
+            warmUp();
         }
         break;
     case MainMenu::Browse:
@@ -168,7 +209,11 @@ void Wizard::showMenu()
             QString prefixName = act->property("PrefixName").toString();
             QString prefixHash = act->property("PrefixHash").toString();
             if (Dialogs::confirm(tr(R"(Are you sure you want to delete "%1"?)").arg(prefixName)))
+            {
+                Launcher::removeAll(prefixHash);
                 FS::removePrefix(prefixHash);
+                reclaim();
+            }
         }
         break;
     case MainMenu::Settings:
@@ -183,14 +228,18 @@ void Wizard::showMenu()
     case MainMenu::Quit:
         if (Dialogs::confirm(tr("Are you sure you want to quit from Wine Wizard?")))
         {
-            QString termScript = FS::readFile(":/terminate");
-            for (const QString &prefixHash : mRunList)
-                Ex::wait(QString(termScript), prefixHash);
             qApp->setProperty("Quit", true);
-            QApplication::exit();
+            QStringList prefixes = Ex::running();
+            qint64 now = QDateTime::currentMSecsSinceEpoch();
+            for (auto it = mWarm.cbegin(); it != mWarm.cend(); ++it)
+                if (it.value() > now && !prefixes.contains(it.key()))
+                    prefixes.append(it.key());
+            mWarm.clear();
+            Ex::terminate(prefixes, []{ QApplication::exit(); });
         }
         break;
     }
+    checkIdle();
 }
 
 void Wizard::install(const QString &cmdLine)
@@ -209,44 +258,186 @@ void Wizard::install(const QString &cmdLine)
         Dialogs::error(tr(R"(File "%1" is not a valid Windows application!)").arg(exe));
         return;
     }
-    QString prefixName, arch, bs, acs, as;
-    if (prepare(prefixName, arch, bs, acs, as))
+    QString prefixName, arch, wine, bs, acs, as;
+    QStringList pending;
+    QVariantMap manifest;
+    if (prepare(prefixName, arch, wine, bs, acs, as, pending, manifest))
     {
-        QString prefixHash = FS::hash(prefixName);
+        Installer *installer = new Installer(prefixName, arch, wine, bs, acs, as, this);
+        QString prefixHash = installer->prefixHash();
+        QString solution = FS::hash(FS::readFile(FS::temp().absoluteFilePath("solution")) + arch);
+        manifest.insert("Exe", exe);
+        installer->setManifest(manifest);
+        bool resume = false;
         if (FS::prefix(prefixHash).exists())
-            FS::removePrefix(prefixHash);
+        {
+            if (Installer::resumable(prefixHash, solution))
+                resume = Dialogs::confirm(tr(R"(The previous installation of "%1" did not finish. Resume it from the first incomplete step?)")
+                                          .arg(prefixName));
+            else if (Installer::updatable(prefixHash, manifest) &&
+                     Dialogs::confirm(tr(R"("%1" is already installed. Update it in place and reinstall only what changed? Choose "No" to remove it and install from scratch.)")
+                                      .arg(prefixName)))
+                resume = Installer::update(prefixHash, solution, manifest);
+            if (!resume)
+            {
+                Launcher::removeAll(prefixHash);
+                FS::removePrefix(prefixHash);
+                reclaim();
+            }
+        }
         mBusyList.append(prefixHash);
-        Ex::terminal(bs, prefixHash);
-        QSettings sol(FS::prefix(prefixHash).absoluteFilePath(".settings"), QSettings::IniFormat);
-        sol.setIniCodec("UTF-8");
-        sol.setValue("Name", prefixName);
-        mRunList.append(prefixHash);
-        Ex::release(FS::readFile(":/create"), prefixHash);
-        mRunList.removeOne(prefixHash);
-        if (qApp->property("Quit").toBool())
-            return;
-        QString wmbPath = FS::sys32(prefixHash, arch).absoluteFilePath("winemenubuilder.exe");
-        QFile::remove(wmbPath);
-        QFile::copy(":/winemenubuilder.exe", wmbPath);
-        if (arch == "64")
+        connect(installer, &Installer::finished, this, &Wizard::installFinished);
+        installer->start(exe, workDir, args, pending, solution, resume);
+    }
+}
+
+void Wizard::debugFinished(Ex::Job *job)
+{
+    if (qApp->property("Quit").toBool())
+        return;
+    QString shortcut = job->property("Shortcut").toString();
+    if (Dialogs::finish(job->prefixHash()))
+    {
+        if (!shortcut.isEmpty())
         {
-            wmbPath = FS::sys64(prefixHash).absoluteFilePath("winemenubuilder.exe");
-            QFile::remove(wmbPath);
-            QFile::copy(":/winemenubuilder64.exe", wmbPath);
+            QSettings s(shortcut, QSettings::IniFormat);
+            s.setValue("Debug", false);
         }
-        if (!acs.isEmpty())
-            Ex::terminal(acs, prefixHash);
-        QString script = FS::readFile(":/run").arg(exe).arg(workDir).arg(args);
-        mRunList.append(prefixHash);
-        Ex::Out out = Ex::debug(script, prefixHash);
-        mRunList.removeOne(prefixHash);
-        if (qApp->property("Quit").toBool())
-            return;
-        Ex::terminal(as, prefixHash);
-        mBusyList.removeOne(prefixHash);
-        if (!Dialogs::finish(prefixHash))
-            OutputDialog(out).exec();
     }
+    else
+        OutputDialog(job->log(), job->analyzer()).exec();
+    checkIdle();
+}
+
+void Wizard::ephemeralFinished(Ephemeral *ephemeral)
+{
+    if (!qApp->property("Quit").toBool() && ephemeral->exitCode() != 0 && ephemeral->log())
+        OutputDialog(ephemeral->log(), ephemeral->analyzer()).exec();
+    ephemeral->deleteLater();
+    checkIdle();
+}
+
+void Wizard::installFinished(Installer *installer)
+{
+    mBusyList.removeOne(installer->prefixHash());
+    if (qApp->property("Quit").toBool())
+    {
+        installer->deleteLater();
+        return;
+    }
+    if (!Dialogs::finish(installer->prefixHash()) && installer->log())
+        OutputDialog(installer->log(), installer->analyzer()).exec();
+    installer->deleteLater();
+    if (persistent())
+        Templates::refill();
+    checkIdle();
+}
+
+void Wizard::checkIdle()
+{
+    if (!persistent() && idle())
+        QApplication::exit();
+}
+
+bool Wizard::persistent() const
+{
+    return mTray && !mTray->property("Autoclose").toBool();
+}
+
+void Wizard::reclaim()
+{
+    Templates::prune();
+    FS::reclaim([this](qint64 freed)
+    {
+        if (mTray && freed >= MIB)
+            mTray->showMessage(tr("Wine Wizard"), tr("%1 MiB of disk space reclaimed.").arg(freed / MIB));
+        if (Templates::prune())
+            reclaim();
+        checkIdle();
+    });
+}
+
+void Wizard::warmUp()
+{
+    QSettings s("winewizard", "settings");
+    s.beginGroup("Warm");
+    if (!s.value("Enabled", false).toBool())
+        return;
+    int timeout = s.value("Timeout", 10).toInt();
+    QStringList list = s.value("Recent").toStringList();
+    s.endGroup();
+    for (const QString &hash : FS::data().entryList(QDir::AllDirs | QDir::NoDotAndDotDot))
+    {
+        QSettings p(FS::prefix(hash).absoluteFilePath(".settings"), QSettings::IniFormat);
+        if (p.value("Warm", false).toBool() && !list.contains(hash))
+            list.append(hash);
+    }
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (auto it = mWarm.begin(); it != mWarm.end();)
+        if (it.value() <= now)
+            it = mWarm.erase(it);
+        else
+            ++it;
+    for (const QString &hash : list)
+        if (FS::wine(hash).exists() && !mBusyList.contains(hash) && mWarm.value(hash) - now < timeout * 30000 &&
+            !Proc::suspended(FS::prefix(hash).absolutePath()))
+        {
+            Ex::warm(hash, timeout);
+            mWarm.insert(hash, now + timeout * 60000);
+        }
+}
+
+Ex::Job *Wizard::launch(QAction *act, Ex::Job::Mode mode)
+{
+    QString exe = act->property("Exe").toString();
+    QString args = act->property("Args").toString();
+    QString workDir = act->property("WorkDir").toString();
+    QString prefixHash = act->property("PrefixHash").toString();
+    QString shortcut = act->property("Shortcut").toString();
+    QProcessEnvironment overlay = launchEnv(prefixHash, act->property("Presets").toMap());
+    QString profile;
+    if (!shortcut.isEmpty())
+    {
+        profile = Prefetcher::profile(shortcut);
+        Prefetcher::prefetch(profile);
+    }
+    Ex::Job *job = Ex::launch(mode, exe, workDir, args, prefixHash, overlay);
+    job->setProperty("Shortcut", shortcut);
+    keepWarm(job);
+    if (!profile.isEmpty() && Prefetcher::stale(profile))
+        new Prefetcher(job, profile);
+    return job;
+}
+
+QProcessEnvironment Wizard::launchEnv(const QString &prefixHash, const QVariantMap &presets)
+{
+    QSettings s("winewizard", "settings");
+    s.beginGroup("Warm");
+    if (s.value("Enabled", false).toBool())
+    {
+        QStringList recent = s.value("Recent").toStringList();
+        recent.removeAll(prefixHash);
+        recent.prepend(prefixHash);
+        s.setValue("Recent", recent.mid(0, MAX_RECENT_WARM));
+    }
+    s.endGroup();
+    QProcessEnvironment res = Ex::overlay(presets);
+    if (mWarm.value(prefixHash) > QDateTime::currentMSecsSinceEpoch())
+        res.insert("WW_WARM", "1");
+    return res;
+}
+
+void Wizard::keepWarm(Ex::Job *job)
+{
+    if (mWarm.value(job->prefixHash()) <= QDateTime::currentMSecsSinceEpoch())
+        return;
+    connect(job, &Ex::Job::finished, this, [this](Ex::Job *done)
+    {
+        if (!mWarm.contains(done->prefixHash()))
+            return;
+        int timeout = QSettings("winewizard", "settings").value("Warm/Timeout", 10).toInt();
+        mWarm.insert(done->prefixHash(), QDateTime::currentMSecsSinceEpoch() + timeout * 60000);
+    });
 }
 
 bool Wizard::testSuffix(const QFileInfo &path) const
@@ -255,7 +446,8 @@ bool Wizard::testSuffix(const QFileInfo &path) const
     return suffix == "EXE" || suffix == "MSI";
 }
 
-bool Wizard::prepare(QString &name, QString &arch, QString &bs, QString &acs, QString &as) const
+bool Wizard::prepare(QString &name, QString &arch, QString &wine, QString &bs, QString &acs, QString &as,
+                     QStringList &pending, QVariantMap &manifest) const
 {
     QDir cache = FS::cache();
     QString repoPath = cache.absoluteFilePath("main.wwrepo");
@@ -280,7 +472,7 @@ bool Wizard::prepare(QString &name, QString &arch, QString &bs, QString &acs, QS
         return false;
     }
     clearRepository();
-    SolutionDialog solDlg(mRunList);
+    SolutionDialog solDlg(Ex::running());
     if (solDlg.exec() != QDialog::Accepted)
         return false;
     SelectArchDialog sad;
@@ -305,6 +497,7 @@ bool Wizard::prepare(QString &name, QString &arch, QString &bs, QString &acs, QS
     QJsonObject jo = jd.object();
     name = jo.value("name").toString();
     QString bw = jo.value("bw").toString();
+    wine = bw;
     QString aw = jo.value("aw").toString();
     QStringList bp;
     QJsonArray bpArr = jo.value("bp").toArray();
@@ -316,29 +509,48 @@ bool Wizard::prepare(QString &name, QString &arch, QString &bs, QString &acs, QS
         ap.append((*iter).toString());
     QString bScript = jo.value("bs").toString();
     QString aScript = jo.value("as").toString();
-    QSet<QString> files;
+    manifest.clear();
+    manifest.insert("Arch", arch);
+    manifest.insert("BW", bw);
+    manifest.insert("AW", aw);
+    manifest.insert("BP", bp);
+    manifest.insert("AP", ap);
+    QSet<QString> files, wineFiles;
     r.beginGroup("Packages" + arch);
-    required(bw, files, &r);
+    required(bw, wineFiles, &r);
     required(aw, files, &r);
+    QString awFiles = stepFiles(aw, &r);
     for (const QString &p : bp)
         required(p, files, &r);
     for (const QString &p : ap)
         required(p, files, &r);
+    QSet<QString> scheduled;
+    QString bSchedule = schedule(bp, scheduled, &r);
+    QString aSchedule = schedule(ap, scheduled, &r);
     r.endGroup();
+    files.subtract(wineFiles);
+    pending.clear();
     r.beginGroup("Files");
-    for (const QString &f : files)
+    for (const QString &f : wineFiles + files)
     {
         r.beginGroup(f);
         QString checksum = r.value("Sum").toString();
         QString out = FS::cache().absoluteFilePath(f);
         if (!QFile::exists(out) || !FS::checkFileSum(out, checksum))
         {
+            if (!wineFiles.contains(f))
+            {
+                pending.append(f);
+                r.endGroup();
+                continue;
+            }
             QStringList mirrors = r.value("Mirrors").toStringList();
             QStringList reList = r.value("RE").toStringList();
             DownloadDialog dd(mirrors, out, nullptr, checksum, reList);
             if (dd.exec() != QDialog::Accepted)
                 return false;
         }
+        Fetcher::markReady(f);
         r.endGroup();
     }
     r.endGroup();
@@ -355,23 +567,35 @@ bool Wizard::prepare(QString &name, QString &arch, QString &bs, QString &acs, QS
     if (!bp.isEmpty() || !bScript.isEmpty())
     {
         acs = bs;
-        for (const QString &p : bp)
-            acs += "ww_install " + p + '\n';
+        acs += QString(LAYER_STATE).arg(bw).arg(arch).arg(scrW + 'x' + scrH).arg(vmSize);
+        acs += bSchedule;
     }
     bs += "ww_install_wine " + QString(bw) + '\n';
     as = constScript;
     as += QString(is).arg(arch).arg(aw).arg(scrW + 'x' + scrH).arg(vmSize);
     if (aw != bw)
-        as += "ww_install_wine " + QString(aw) + '\n';
-    for (const QString &p : ap)
-        as += "ww_install " + p + '\n';
+        as += "ww_need " + awFiles + "\nww_install_wine " + QString(aw) + '\n';
+    as += aSchedule;
     if ((!bScript.isEmpty() || !aScript.isEmpty()) && s.value("UseScripts", false).toBool())
         if (ScriptDialog(bScript, aScript).exec() == QDialog::Accepted)
         {
+            if (!pending.isEmpty())
+            {
+                acs += "ww_need " + pending.join(' ') + '\n';
+                as += "ww_need " + pending.join(' ') + '\n';
+            }
             if (!bScript.isEmpty())
-                acs += "ww_info 'Start additional script ...'\n" + bScript.replace("\\", "\\\\") + '\n';
+            {
+                QString hash = FS::hash(bScript);
+                manifest.insert("BS", hash);
+                acs += QString(SCRIPT_STEP).arg(hash).arg(bScript.replace("\\", "\\\\"));
+            }
             if (!aScript.isEmpty())
-                as += "ww_info 'Start additional script ...'\n" + aScript.replace("\\", "\\\\") + '\n';
+            {
+                QString hash = FS::hash(aScript);
+                manifest.insert("AS", hash);
+                as += QString(SCRIPT_STEP).arg(hash).arg(aScript.replace("\\", "\\\\"));
+            }
         }
     as += r.value("Done").toString();
     return true;
@@ -388,6 +612,79 @@ void Wizard::required(const QString &package, QSet<QString> &res, QSettings *r)
         required(p, res, r);
 }
 
+void Wizard::level(const QString &package, QHash<QString, int> &res, QStringList &order, QSettings *r) const
+{
+    if (res.contains(package))
+        return;
+    res.insert(package, 0);
+    r->beginGroup(package);
+    QStringList req = r->value("Required").toStringList();
+    r->endGroup();
+    int l = 0;
+    for (const QString &p : req)
+    {
+        level(p, res, order, r);
+        l = qMax(l, res.value(p) + 1);
+    }
+    res.insert(package, l);
+    order.append(package);
+}
+
+QString Wizard::stepFiles(const QString &package, QSettings *r) const
+{
+    QSet<QString> files;
+    required(package, files, r);
+    QStringList res = files.toList();
+    res.sort();
+    return res.join(' ');
+}
+
+QString Wizard::schedule(const QStringList &packages, QSet<QString> &scheduled, QSettings *r) const
+{
+    QHash<QString, int> levels;
+    QStringList order;
+    for (const QString &p : packages)
+        level(p, levels, order, r);
+    QMap<int, QStringList> exclusive, parallel;
+    int count = 0;
+    for (const QString &p : order)
+    {
+        if (scheduled.contains(p))
+            continue;
+        r->beginGroup(p);
+        bool isPackage = r->value("Type", PT_PACKAGE).toInt() == PT_PACKAGE;
+        bool isParallel = r->value("Parallel", false).toBool();
+        r->endGroup();
+        if (!isPackage)
+            continue;
+        scheduled.insert(p);
+        if (isParallel)
+            parallel[levels.value(p)].append(p);
+        else
+            exclusive[levels.value(p)].append(p);
+        ++count;
+    }
+    if (count == 0)
+        return QString();
+    int maxLevel = 0;
+    for (int l : levels)
+        maxLevel = qMax(maxLevel, l);
+    QString res = "WW_STEPS=$(mktemp -d)\n";
+    int step = 0;
+    for (int l = 0; l <= maxLevel; ++l)
+    {
+        QStringList par = parallel.value(l), exc = exclusive.value(l);
+        for (const QString &p : par)
+            res += QString("ww_step_bg %1/%2 %3 %4\n").arg(++step).arg(count).arg(p).arg(stepFiles(p, r));
+        if (!par.isEmpty())
+            res += "ww_step_wait " + par.join(' ') + '\n';
+        for (const QString &p : exc)
+            res += QString("ww_step %1/%2 %3 %4\n").arg(++step).arg(count).arg(p).arg(stepFiles(p, r));
+    }
+    res += "rm -rf \"$WW_STEPS\"\n";
+    return res;
+}
+
 void Wizard::clearRepository() const
 {
     QDir cache = FS::cache();
@@ -404,6 +701,11 @@ void Wizard::clearRepository() const
             else
                 QFile::remove(f.absoluteFilePath());
         }
+    QDir layers = FS::layers();
+    QDateTime expired = QDateTime::currentDateTime().addDays(-LAYER_MAX_AGE);
+    for (const QString &layer : layers.entryList(QDir::Dirs | QDir::NoDotAndDotDot))
+        if (QFileInfo(layers.absoluteFilePath(layer + "/done")).lastModified() < expired)
+            QDir(layers.absoluteFilePath(layer)).removeRecursively();
 }
 
 QString Wizard::makeConstScript(const QString &arch) const
@@ -415,10 +717,24 @@ QString Wizard::makeConstScript(const QString &arch) const
     {
         r.beginGroup(f);
         QString body = r.value("Body").toString();
-        res += PREPARE_FUNCTIONS.arg(f).arg(body);
+        if (f == "install_wine")
+        {
+            res += PREPARE_FUNCTIONS.arg("repo_" + f).arg(body);
+            res += FS::readFile(":/wines").arg(FS::wines().absolutePath()).arg(arch);
+        }
+        else
+            res += PREPARE_FUNCTIONS.arg(f).arg(body);
         r.endGroup();
     }
     r.endGroup();
+    res += FS::readFile(":/extract").arg(QApplication::applicationFilePath());
+    res += FS::readFile(":/layers").arg(FS::layers().absolutePath());
+    res += FS::readFile(":/steps").arg(Fetcher::ready().absolutePath());
+    QHash<QString, QString> sums;
+    r.beginGroup("Files");
+    for (const QString &f : r.childGroups())
+        sums.insert(f, r.value(f + "/Sum").toString());
+    r.endGroup();
     r.beginGroup("Packages" + arch);
     for (const QString &p : r.childGroups())
     {
@@ -428,7 +744,10 @@ QString Wizard::makeConstScript(const QString &arch) const
         {
             QString check = r.value("Check").toString();
             QString install = r.value("Install").toString();
-            res += PREPARE_PACKAGES.arg(p).arg(check).arg(install);
+            QString definition = install + '\n' + r.value("Required").toStringList().join(' ');
+            for (const QString &f : r.value("Files").toStringList())
+                definition += '\n' + f + ' ' + sums.value(f);
+            res += PREPARE_PACKAGES.arg(p, check, install, FS::hash(definition));
         }
         r.endGroup();
     }
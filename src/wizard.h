@@ -25,6 +25,12 @@
 #include <QStringList>
 #include <QFileInfo>
 #include <QSettings>
+#include <QAction>
+
+#include "executor.h"
+
+class Installer;
+class Ephemeral;
 
 class Wizard : public QObject
 {
@@ -33,20 +39,37 @@ class Wizard : public QObject
 public:
     explicit Wizard(bool trayVisible, bool autoclose, QObject *parent = nullptr);
 
+    bool idle() const;
+
 public slots:
     void start(const QString &cmdLine = QString());
 
 private slots:
     void showMenu();
+    void debugFinished(Ex::Job *job);
+    void installFinished(Installer *installer);
+    void ephemeralFinished(Ephemeral *ephemeral);
+    void checkIdle();
+    void warmUp();
+    void reclaim();
 
 private:
-    QStringList mBusyList, mRunList;
+    QStringList mBusyList;
     QSystemTrayIcon *mTray;
+    QHash<QString, qint64> mWarm;
 
+    bool persistent() const;
+    Ex::Job *launch(QAction *act, Ex::Job::Mode mode);
+    QProcessEnvironment launchEnv(const QString &prefixHash, const QVariantMap &presets);
+    void keepWarm(Ex::Job *job);
     void install(const QString &cmdLine);
     bool testSuffix(const QFileInfo &path) const;
-    bool prepare(QString &name, QString &arch, QString &bs, QString &acs, QString &as) const;
+    bool prepare(QString &name, QString &arch, QString &wine, QString &bs, QString &acs, QString &as,
+                 QStringList &pending, QVariantMap &manifest) const;
     void required(const QString &package, QSet<QString> &res, QSettings *r) const;
+    void level(const QString &package, QHash<QString, int> &res, QStringList &order, QSettings *r) const;
+    QString stepFiles(const QString &package, QSettings *r) const;
+    QString schedule(const QStringList &packages, QSet<QString> &scheduled, QSettings *r) const;
     void clearRepository() const;
     QString makeConstScript(const QString &arch) const;
 };
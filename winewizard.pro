@@ -8,6 +8,8 @@ QT       += core gui network
 
 QMAKE_CXXFLAGS += -std=c++11
 
+LIBS += -larchive
+
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
 VERSION = 1.1.0
@@ -62,7 +64,20 @@ SOURCES += src/qtsingleapplication/qtlocalpeer.cpp \
     src/editprefixdialog.cpp \
     src/editsolutiondialog.cpp \
     src/settingsdialog.cpp \
-    src/scriptdialog.cpp
+    src/scriptdialog.cpp \
+    src/installer.cpp \
+    src/runlog.cpp \
+    src/loganalyzer.cpp \
+    src/process.cpp \
+    src/prefetcher.cpp \
+    src/launcher.cpp \
+    src/presetwidget.cpp \
+    src/shadercache.cpp \
+    src/ephemeral.cpp \
+    src/templates.cpp \
+    src/fetcher.cpp \
+    src/extractor.cpp \
+    src/transfer.cpp
 
 HEADERS  += src/qtsingleapplication/qtlocalpeer.h \
     src/qtsingleapplication/qtlockedfile.h \
@@ -93,7 +108,20 @@ HEADERS  += src/qtsingleapplication/qtlocalpeer.h \
     src/editprefixdialog.h \
     src/editsolutiondialog.h \
     src/settingsdialog.h \
-    src/scriptdialog.h
+    src/scriptdialog.h \
+    src/installer.h \
+    src/runlog.h \
+    src/loganalyzer.h \
+    src/process.h \
+    src/prefetcher.h \
+    src/launcher.h \
+    src/presetwidget.h \
+    src/shadercache.h \
+    src/ephemeral.h \
+    src/templates.h \
+    src/fetcher.h \
+    src/extractor.h \
+    src/transfer.h
 
 FORMS    += src/solutiondialog.ui \
     src/aboutdialog.ui \
@@ -108,7 +136,8 @@ FORMS    += src/solutiondialog.ui \
     src/editprefixdialog.ui \
     src/editsolutiondialog.ui \
     src/settingsdialog.ui \
-    src/scriptdialog.ui
+    src/scriptdialog.ui \
+    src/presetwidget.ui
 
 RESOURCES += \
     src/resources.qrc